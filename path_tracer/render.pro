@@ -0,0 +1,31 @@
+# The command line renderer. It needs no window system or OpenGL context, so it builds and runs on
+# headless machines:
+#     render [-i direct|total|photonMap|sppm] [-t threads] [-s samples per pixel] [-o image.bmp] scene.xml
+# --benchmark-photons times photon map tracing and lookups and --benchmark-bvh times the mesh BVH
+# builds at 1 to 16 threads, both instead of rendering.
+QT += core gui
+QT -= widgets
+
+TARGET = render
+TEMPLATE = app
+CONFIG += c++11
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG += warn_on
+
+INCLUDEPATH += include
+
+include(src/core.pri)
+
+SOURCES += src/rendermain.cpp
+
+macx {
+    INCLUDEPATH += /usr/local/include
+}
+
+*-clang*|*-g++* {
+    CONFIG -= warn_on
+    QMAKE_CXXFLAGS += -Wall -Wextra -pedantic -Winit-self
+    QMAKE_CXXFLAGS += -Wno-strict-aliasing
+    QMAKE_CXXFLAGS += -Wno-unneeded-internal-declaration
+}
@@ -0,0 +1,123 @@
+# Everything the renderer needs without a window or an OpenGL context; shared by 277.pro and render.pro.
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+#LIBS += -L$$PWD/lib -ltbb
+
+SOURCES += \
+    $$PWD/scene/camera.cpp \
+    $$PWD/scene/scene.cpp \
+    $$PWD/bmp/EasyBMP.cpp \
+    $$PWD/scene/geometry/cube.cpp \
+    $$PWD/scene/geometry/mesh.cpp \
+    $$PWD/scene/geometry/sphere.cpp \
+    $$PWD/openGL/drawable.cpp \
+    $$PWD/raytracing/intersection.cpp \
+    $$PWD/raytracing/ray.cpp \
+    $$PWD/scene/transform.cpp \
+    $$PWD/scene/geometry/square.cpp \
+    $$PWD/tinyobj/tiny_obj_loader.cc \
+    $$PWD/scene/materials/material.cpp \
+    $$PWD/scene/materials/weightedmaterial.cpp \
+    $$PWD/raytracing/film.cpp \
+    $$PWD/raytracing/filter.cpp \
+    $$PWD/scene/xmlreader.cpp \
+    $$PWD/raytracing/integrator.cpp \
+    $$PWD/raytracing/samplers/stratifiedpixelsampler.cpp \
+    $$PWD/raytracing/samplers/uniformpixelsampler.cpp \
+    $$PWD/raytracing/samplers/sampler.cpp \
+    $$PWD/raytracing/samplers/independentsampler.cpp \
+    $$PWD/raytracing/samplers/sobolsampler.cpp \
+    $$PWD/raytracing/samplers/haltonsampler.cpp \
+    $$PWD/raytracing/samplers/aliastable.cpp \
+    $$PWD/scene/geometry/disc.cpp \
+    $$PWD/scene/materials/bxdfs/blinnmicrofacetbxdf.cpp \
+    $$PWD/scene/materials/bxdfs/lambertBxDF.cpp \
+    $$PWD/scene/materials/bxdfs/bxdf.cpp \
+    $$PWD/scene/materials/bxdfs/specularreflectionbxdf.cpp \
+    $$PWD/scene/materials/lightmaterial.cpp \
+    $$PWD/renderthread.cpp \
+    $$PWD/renderer.cpp \
+    $$PWD/scene/geometry/geometry.cpp \
+    $$PWD/scene/geometry/boundingbox.cpp \
+    $$PWD/scene/geometry/linearbvh.cpp \
+    $$PWD/scene/geometry/trianglepacket.cpp \
+    $$PWD/scene/geometry/widebvh.cpp \
+    $$PWD/scene/geometry/meshcache.cpp \
+    $$PWD/raytracing/tilescheduler.cpp \
+    $$PWD/raytracing/previewqueue.cpp \
+    $$PWD/raytracing/totallightingintegrator.cpp \
+    $$PWD/raytracing/directlightingintegrator.cpp \
+    $$PWD/scene/materials/bxdfs/speculartransmissionbxdf.cpp \
+    $$PWD/scene/materials/bxdfs/anisotropicbxdf.cpp \
+    $$PWD/raytracing/photonmapintegrator.cpp \
+    $$PWD/raytracing/photonhashgrid.cpp \
+    $$PWD/raytracing/sppmintegrator.cpp \
+    $$PWD/scene/materials/volumetricmaterial.cpp
+
+HEADERS += \
+    $$PWD/scene/camera.h \
+    $$PWD/la.h \
+    $$PWD/drawable.h \
+    $$PWD/scene/scene.h \
+    $$PWD/bmp/EasyBMP.h \
+    $$PWD/bmp/EasyBMP_BMP.h \
+    $$PWD/bmp/EasyBMP_DataStructures.h \
+    $$PWD/bmp/EasyBMP_VariousBMPutilities.h \
+    $$PWD/scene/geometry/cube.h \
+    $$PWD/scene/geometry/geometry.h \
+    $$PWD/scene/geometry/mesh.h \
+    $$PWD/scene/geometry/sphere.h \
+    $$PWD/openGL/drawable.h \
+    $$PWD/raytracing/intersection.h \
+    $$PWD/raytracing/ray.h \
+    $$PWD/scene/transform.h \
+    $$PWD/scene/geometry/square.h \
+    $$PWD/tinyobj/tiny_obj_loader.h \
+    $$PWD/scene/materials/material.h \
+    $$PWD/scene/materials/weightedmaterial.h \
+    $$PWD/raytracing/film.h \
+    $$PWD/raytracing/filter.h \
+    $$PWD/scene/xmlreader.h \
+    $$PWD/raytracing/integrator.h \
+    $$PWD/raytracing/samplers/pixelsampler.h \
+    $$PWD/raytracing/samplers/stratifiedpixelsampler.h \
+    $$PWD/raytracing/samplers/uniformpixelsampler.h \
+    $$PWD/raytracing/samplers/pcg32.h \
+    $$PWD/raytracing/samplers/lowdiscrepancy.h \
+    $$PWD/raytracing/samplers/sampler.h \
+    $$PWD/raytracing/samplers/independentsampler.h \
+    $$PWD/raytracing/samplers/sobolsampler.h \
+    $$PWD/raytracing/samplers/haltonsampler.h \
+    $$PWD/raytracing/samplers/aliastable.h \
+    $$PWD/scene/geometry/disc.h \
+    $$PWD/scene/materials/bxdfs/blinnmicrofacetbxdf.h \
+    $$PWD/scene/materials/bxdfs/lambertBxDF.h \
+    $$PWD/scene/materials/bxdfs/bxdf.h \
+    $$PWD/scene/materials/bxdfs/specularreflectionbxdf.h \
+    $$PWD/scene/materials/lightmaterial.h \
+    $$PWD/renderthread.h \
+    $$PWD/renderer.h \
+    $$PWD/raytracing/intersectionengine.h \
+    $$PWD/scene/geometry/boundingbox.h \
+    $$PWD/scene/geometry/bvhbuildoptions.h \
+    $$PWD/scene/geometry/linearbvh.h \
+    $$PWD/scene/geometry/bvhsplit.h \
+    $$PWD/scene/geometry/trianglepacket.h \
+    $$PWD/scene/geometry/widebvh.h \
+    $$PWD/scene/geometry/bvhleaftests.h \
+    $$PWD/scene/geometry/meshcache.h \
+    $$PWD/raytracing/renderoptions.h \
+    $$PWD/raytracing/tilescheduler.h \
+    $$PWD/raytracing/previewqueue.h \
+    $$PWD/raytracing/totallightingintegrator.h \
+    $$PWD/raytracing/directlightingintegrator.h \
+    $$PWD/helpers.h \
+    $$PWD/scene/materials/bxdfs/speculartransmissionbxdf.h \
+    $$PWD/raytracing/kdtree.h \
+    $$PWD/raytracing/neighborlookup.h \
+    $$PWD/raytracing/photonhashgrid.h \
+    $$PWD/raytracing/sppmintegrator.h \
+    $$PWD/raytracing/photon.h \
+    $$PWD/raytracing/photonmapintegrator.h \
+    $$PWD/scene/materials/bxdfs/anisotropicbxdf.h \
+    $$PWD/scene/materials/volumetricmaterial.h
@@ -14,6 +14,7 @@ inline void ConcentricSampleDisk(float u1, float u2, float &x, float &y)
     {
         x = 0;
         y = 0;
+        return;
     }
     if (sx >= -sy)
     {
@@ -8,6 +8,7 @@
 #include <QFileDialog>
 #include <renderthread.h>
 #include <raytracing/samplers/stratifiedpixelsampler.h>
+#include <raytracing/samplers/independentsampler.h>
 #include <scene/materials/volumetricmaterial.h>
 
 
@@ -111,7 +112,7 @@ void MyGL::initializeGL()
     integrator.scene = &scene;
     integrator.intersection_engine = &intersection_engine;
     intersection_engine.scene = &scene;
-    intersection_engine.bvh = bvhNode::InitTree(scene.objects);
+    intersection_engine.BuildBVH(scene.bvh_options);
     ResizeToSceneCamera();
 
     printGLErrorLog();
@@ -278,7 +279,12 @@ void MyGL::SceneLoadDialog()
     integrator.scene = &scene;
     integrator.intersection_engine = &intersection_engine;
     intersection_engine.scene = &scene;
-    intersection_engine.bvh = bvhNode::InitTree(scene.objects);
+    intersection_engine.BuildBVH(scene.bvh_options);
+    std::cout << "Scene BVH built with "
+              << (scene.bvh_options.split_method == BVH_SPLIT_SAH ? "SAH" : "median")
+              << " splits, SAH cost " << bvhNode::SAHCost(intersection_engine.bvh, scene.bvh_options)
+              << ", traced with " << (intersection_engine.use_wide_bvh ? scene.bvh_options.branching_factor : 2)
+              << " children per node" << std::endl;
 
 #ifdef PHOTON_MAP
     integrator.PrePass();
@@ -294,52 +300,57 @@ void MyGL::SceneLoadDialog()
     }
 }
 
-void MyGL::cleanThreads(){
-    if(!signal)
+void MyGL::DrainPreviewQueue(){
+    //The queue hands tiles back newest first; reverse them so a later pass's colors win
+    PreviewTile* newest = preview_queue.TakeAll();
+    PreviewTile* tile = NULL;
+    while(newest != NULL)
     {
-        for(unsigned int i = 0; i < num_render_threads; i++)
-        {
-            delete render_threads[i];
-        }
-        delete [] render_threads;
-        signal = true;
+        PreviewTile* next = newest->next;
+        newest->next = tile;
+        tile = newest;
+        newest = next;
     }
-}
-
-void MyGL::render_check(){
-    bool still_running;
-    if(rendering){
-        still_running = false;
-        for(unsigned int i = 0; i < num_render_threads; i++)
+    while(tile != NULL)
+    {
+        const glm::vec3* color = tile->colors.data();
+        for(unsigned int Y = tile->tile.y_start; Y < tile->tile.y_end; Y++)
         {
-            if(render_threads[i]->isRunning())
+            for(unsigned int X = tile->tile.x_start; X < tile->tile.x_end; X++, color++)
             {
-                still_running = true;
-                update();
-                break;
+                p_img.setPixel(X, Y, qRgb(color->x * 255, color->y * 255 , color->z * 255));
             }
         }
-        if(still_running)
+        PreviewTile* next = tile->next;
+        delete tile;
+        tile = next;
+    }
+}
+
+void MyGL::render_tile_finished(){
+    if(!rendering)
+    {
+        return;
+    }
+    //Several tiles may have been pushed since the last call; later calls find the queue empty
+    DrainPreviewQueue();
+    update();
+    if(renderer.IsPassFinished())
+    {
+        if(!renderer.FinishPass())
         {
-            //Free the CPU to let the remaining render threads use it
-            QThread::yieldCurrentThread();
+            renderer.StartPass();
+            return;
         }
-        else{
-            rendering = false;
-            DenoisePixels();
-            scene.film.WriteImage(filepath);
-        }
-    }
-    else{
-        //Finally, clean up the render thread objects
-        cleanThreads();
+        rendering = false;
+        renderer.PrintStats();
+        DenoisePixels();
+        renderer.WriteImages(filepath);
     }
-
 }
 
 void MyGL::RaytraceScene()
 {
-    signal = false;
     filepath = QFileDialog::getSaveFileName(0, QString("Save Image"), QString("../rendered_images"), tr("*.bmp"));
     if(filepath.length() == 0)
     {
@@ -351,69 +362,21 @@ void MyGL::RaytraceScene()
 //#define PERLIN_TEST
 #define MULTITHREADED
 #ifdef MULTITHREADED
-    //Set up 16 (max) threads
-    unsigned int width = scene.camera.width;
-    unsigned int height = scene.camera.height;
-    unsigned int x_block_size = (width >= 4 ? width/4 : 1);
-    unsigned int y_block_size = (height >= 4 ? height/4 : 1);
-    unsigned int x_block_count = width > 4 ? width/x_block_size : 1;
-    unsigned int y_block_count = height > 4 ? height/y_block_size : 1;
-    if(x_block_count * x_block_size < width) x_block_count++;
-    if(y_block_count * y_block_size < height) y_block_count++;
-
-    num_render_threads = x_block_count * y_block_count;
-    render_threads = new RenderThread*[num_render_threads];
-
-    //Launch the render threads we've made
-    for(unsigned int Y = 0; Y < y_block_count; Y++)
-    {
-        //Compute the columns of the image that the thread should render
-        unsigned int y_start = Y * y_block_size;
-        unsigned int y_end = glm::min((Y + 1) * y_block_size, height);
-        for(unsigned int X = 0; X < x_block_count; X++)
-        {
-            //Compute the rows of the image that the thread should render
-            unsigned int x_start = X * x_block_size;
-            unsigned int x_end = glm::min((X + 1) * x_block_size, width);
-            //Create and run the thread
-            render_threads[Y * x_block_count + X] = new RenderThread(x_start, x_end, y_start, y_end, scene.sqrt_samples, 5, &(scene.film), &(scene.camera), &(integrator), p_img);
-            render_threads[Y * x_block_count + X]->start();
-        }
-    }
+    renderer.Begin(&scene, &integrator, &preview_queue);
 //    #define PROGRESSIVE
     #ifdef PROGRESSIVE
+    //Tiles finish on the render threads, so hand each one to the GUI thread's event loop
+    renderer.SetTileFinishedCallback([this](const RenderTile &) {
+        QMetaObject::invokeMethod(this, "render_tile_finished", Qt::QueuedConnection);
+    });
     rendering = true;
-    QTimer *timer = new QTimer(this);
-    connect(timer, SIGNAL(timeout()), this, SLOT(render_check()));
-    timer->start(1000); //every 1000 milliseconds re render
+    renderer.StartPass();
     #else
-    bool still_running;
-        do
-        {
-            still_running = false;
-            for(unsigned int i = 0; i < num_render_threads; i++)
-            {
-                if(render_threads[i]->isRunning())
-                {
-                    still_running = true;
-                    break;
-                }
-            }
-            if(still_running)
-            {
-                //Free the CPU to let the remaining render threads use it
-                QThread::yieldCurrentThread();
-            }
-        }
-        while(still_running);
-
-        //Finally, clean up the render thread objects
-        for(unsigned int i = 0; i < num_render_threads; i++)
-        {
-            delete render_threads[i];
-        }
-        delete [] render_threads;
-        scene.film.WriteImage(filepath);
+    renderer.SetTileFinishedCallback(nullptr);
+    renderer.Render();
+    DrainPreviewQueue();
+    renderer.PrintStats();
+    renderer.WriteImages(filepath);
     #endif
 
 #elif defined(PERLIN_TEST)
@@ -421,11 +384,12 @@ void MyGL::RaytraceScene()
     {
         for(unsigned int i = 0; i < scene.camera.width; i++)
         {
-            scene.film.pixels[i][j] = glm::vec3(VolumetricMaterial::PerlinNoise_3d(i, j, 10));
+            scene.film.SetPixel(i, j, glm::vec3(VolumetricMaterial::PerlinNoise_3d(i, j, 10)));
         }
     }
 #else
     StratifiedPixelSampler pixel_sampler(scene.sqrt_samples,0);
+    IndependentSampler path_sampler(scene.sqrt_samples * scene.sqrt_samples);
     rendering = true;
     for(unsigned int i = 0; i < scene.camera.width; i++)
     {
@@ -436,11 +400,15 @@ void MyGL::RaytraceScene()
             glm::vec3 accum_color;
             for(int a = 0; a < sample_points.size(); a++)
             {
-                glm::vec3 color = integrator.TraceRay(scene.camera.Raycast(sample_points[a]), 0, i, j);
+                path_sampler.StartPixelSample(glm::ivec2(i, j), a);
+                glm::vec2 lens_sample = path_sampler.Get2D();
+                AOVSample aovs;
+                glm::vec3 color = integrator.TraceRay(scene.camera.Raycast(sample_points[a], lens_sample), 0, path_sampler, &aovs);
+                scene.film.AddPixelAOVs(i, j, aovs);
                 accum_color += color;
             }
-            scene.film.pixels[i][j] = accum_color / (float)sample_points.size();
-//            glm::vec3 pixel_color = scene.film.pixels[i][j];
+            scene.film.SetPixel(i, j, accum_color / (float)sample_points.size());
+//            glm::vec3 pixel_color = scene.film.GetPixel(i, j);
 //            if(pixel_color.x > 1.f) pixel_color.x = 1.f;
 //            if(pixel_color.y > 1.f) pixel_color.y = 1.f;
 //            if(pixel_color.z > 1.f) pixel_color.z = 1.f;
@@ -467,44 +435,44 @@ void MyGL::DenoisePixels() {
     {
         for(unsigned int j = 1; j < scene.camera.height-1; j++)
         {
-            glm::vec3 original_color = scene.film.pixels[i][j];
-            float original_depth = scene.film.pixel_depths[i][j];
+            glm::vec3 original_color = scene.film.GetPixel(i, j);
+            float original_depth = scene.film.GetDepth(i, j);
             std::vector<glm::vec3> neighbors;
 
             // Check surrounding pixels in cardinal directions.
-            if (fabs(scene.film.pixel_depths[i-1][j] - original_depth) < 0.5) {
+            if (fabs(scene.film.GetDepth(i-1, j) - original_depth) < 0.5) {
                 // left
-                neighbors.push_back(scene.film.pixels[i-1][j]);
+                neighbors.push_back(scene.film.GetPixel(i-1, j));
             }
-            if (fabs(scene.film.pixel_depths[i+1][j] - original_depth) < 0.5) {
+            if (fabs(scene.film.GetDepth(i+1, j) - original_depth) < 0.5) {
                 // right
-                neighbors.push_back(scene.film.pixels[i+1][j]);
+                neighbors.push_back(scene.film.GetPixel(i+1, j));
             }
-            if (fabs(scene.film.pixel_depths[i][j-1] - original_depth) < 0.5) {
+            if (fabs(scene.film.GetDepth(i, j-1) - original_depth) < 0.5) {
                 // up
-                neighbors.push_back(scene.film.pixels[i][j-1]);
+                neighbors.push_back(scene.film.GetPixel(i, j-1));
             }
-            if (fabs(scene.film.pixel_depths[i][j+1] - original_depth) < 0.5) {
+            if (fabs(scene.film.GetDepth(i, j+1) - original_depth) < 0.5) {
                 // down
-                neighbors.push_back(scene.film.pixels[i][j+1]);
+                neighbors.push_back(scene.film.GetPixel(i, j+1));
             }
 
             // Check surrounding pixels in cardinal directions.
-            if (fabs(scene.film.pixel_depths[i-1][j+1] - original_depth) < 0.5) {
+            if (fabs(scene.film.GetDepth(i-1, j+1) - original_depth) < 0.5) {
                 // upper_left
-                neighbors.push_back(scene.film.pixels[i-1][j+1]);
+                neighbors.push_back(scene.film.GetPixel(i-1, j+1));
             }
-            if (fabs(scene.film.pixel_depths[i+1][j+1] - original_depth) < 0.5) {
+            if (fabs(scene.film.GetDepth(i+1, j+1) - original_depth) < 0.5) {
                 // upper_right
-                neighbors.push_back(scene.film.pixels[i+1][j+1]);
+                neighbors.push_back(scene.film.GetPixel(i+1, j+1));
             }
-            if (fabs(scene.film.pixel_depths[i-1][j-1] - original_depth) < 0.5) {
+            if (fabs(scene.film.GetDepth(i-1, j-1) - original_depth) < 0.5) {
                 // lower_left
-                neighbors.push_back(scene.film.pixels[i-1][j-1]);
+                neighbors.push_back(scene.film.GetPixel(i-1, j-1));
             }
-            if (fabs(scene.film.pixel_depths[i+1][j-1] - original_depth) < 0.5) {
+            if (fabs(scene.film.GetDepth(i+1, j-1) - original_depth) < 0.5) {
                 // lower_right
-                neighbors.push_back(scene.film.pixels[i+1][j-1]);
+                neighbors.push_back(scene.film.GetPixel(i+1, j-1));
             }
 
             glm::vec3 suggested_color(0);
@@ -525,7 +493,7 @@ void MyGL::DenoisePixels() {
     {
         for(unsigned int j = 1; j < scene.camera.height-1; j++)
         {
-            scene.film.pixels[i][j] = tmp_colors[i][j];
+            scene.film.SetPixel(i, j, tmp_colors[i][j]);
         }
     }
 }
@@ -20,7 +20,7 @@
 #include <raytracing/Integrator.h>
 #include <raytracing/directlightingintegrator.h>
 #include <raytracing/totallightingintegrator.h>
-#include <renderthread.h>
+#include <renderer.h>
 
 #include <raytracing/photonmapintegrator.h>
 
@@ -72,11 +72,12 @@ public:
     void RaytraceScene();
     //reDraw: Progrssive drawing on framebuffer
     void reDraw();
-    //clean and delete threads
-    void cleanThreads();
-
-    unsigned int num_render_threads;
-    RenderThread** render_threads;
+    //runs the passes of a render on the render threads
+    Renderer renderer;
+    //finished tiles waiting to be copied into p_img
+    PreviewQueue preview_queue;
+    //copy every finished tile into p_img
+    void DrainPreviewQueue();
 
     //the custom shader to draw texture on
     QOpenGLShaderProgram prog;
@@ -85,8 +86,6 @@ public:
     bool rendering;
     //image to store the pixel buffer
     QImage p_img;
-    //flag to check if threads still active
-    bool signal = false;
     QString filepath;
 
     void DenoisePixels();
@@ -97,6 +96,6 @@ protected:
 signals:
     void sig_ResizeToCamera(int,int);
 private slots:
-    //function to check if threads active; write to image file
-    void render_check();
+    //called on the GUI thread after each tile is rendered; redraws and writes the image file once all tiles are done
+    void render_tile_finished();
 };
@@ -1,5 +1,7 @@
 #include <openGL/drawable.h>
 
+bool Drawable::gl_enabled = true;
+
 Drawable::Drawable()
     : bufIdx(QOpenGLBuffer::IndexBuffer),
       bufPos(QOpenGLBuffer::VertexBuffer),
@@ -32,3 +34,6 @@ bool Drawable::bindIdx(){return bufIdx.bind();}
 bool Drawable::bindPos(){return bufPos.bind();}
 bool Drawable::bindNor(){return bufNor.bind();}
 bool Drawable::bindCol(){return bufCol.bind();}
+
+void Drawable::setGLEnabled(bool enabled){gl_enabled = enabled;}
+bool Drawable::glEnabled(){return gl_enabled;}
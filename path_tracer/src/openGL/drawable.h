@@ -1,6 +1,5 @@
 #pragma once
 
-#include <openGL/glwidget277.h>
 #include <la.h>
 
 #include <QOpenGLFunctions_3_2_Core>
@@ -22,6 +21,11 @@ public:
     virtual void destroy();     //This is a virtual function; it MAY be overridden by a subclass of Drawable, but it has a base implementation.
     virtual GLenum drawMode();
 
+    //With GL disabled, create() leaves the buffers alone, so scenes can be loaded and rendered
+    //without an OpenGL context. The command line renderer turns it off before loading anything.
+    static void setGLEnabled(bool enabled);
+    static bool glEnabled();
+
     int elemCount();
     bool bindIdx();
     bool bindPos();
@@ -36,4 +40,7 @@ protected:
     QOpenGLBuffer bufPos;
     QOpenGLBuffer bufNor;
     QOpenGLBuffer bufCol;
+
+private:
+    static bool gl_enabled;
 };
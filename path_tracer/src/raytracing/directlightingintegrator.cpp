@@ -13,19 +13,17 @@ inline float PowerHeuristics(float f, float g)
 
 // Helper function for computing the light enegry at a point using a ray generated to a random point on random light.
 // Warning: intersections much be valid and light_intersection /must/ actually be an intersection with a light.
-glm::vec3 DirectLightingIntegrator::SampleLightPdf(Ray r, Intersection intersection, Geometry *light) {
+glm::vec3 DirectLightingIntegrator::SampleLightPdf(Ray r, Intersection intersection, Geometry *light, Sampler &sampler) {
 
     // Get an intersection with the chosen light.
-    float x = float(rand()) / float(RAND_MAX);
-    float y = float(rand()) / float(RAND_MAX);
+    glm::vec2 light_sample = sampler.Get2D();
     glm::vec3 offset_point = intersection.point + (intersection.normal * OFFSET);
 
-    Intersection light_intersection = light->SampleLight(intersection_engine, offset_point, x, y, intersection.normal);
+    Intersection light_intersection = light->SampleLight(intersection_engine, offset_point, light_sample.x, light_sample.y, intersection.normal);
 
-    // If we don't intersect with the chosen light, return black.
-    if (light_intersection.object_hit == NULL ||
-            (light_intersection.object_hit != light &&
-             !light_intersection.object_hit->material->isTransmissive())) {
+    // If the chosen light is missed or occluded, return black.
+    // Transmissive objects do not occlude lights, so this is only ever NULL or the light.
+    if (light_intersection.object_hit == NULL) {
         return glm::vec3(0);
     }
     // Create ray.
@@ -47,7 +45,8 @@ glm::vec3 DirectLightingIntegrator::SampleLightPdf(Ray r, Intersection intersect
                 intersection,
                 -r.direction,
                 bxdf_wi,
-                bxdf_pdf);
+                bxdf_pdf,
+                sampler);
 
     if (fequal(bxdf_pdf, 0.f)) {
         return glm::vec3(0);
@@ -56,7 +55,7 @@ glm::vec3 DirectLightingIntegrator::SampleLightPdf(Ray r, Intersection intersect
     // Energy scattered by intersected light material.
     glm::vec3 light_energy = light_intersection.object_hit->material->EvaluateScatteredEnergy(
                 light_intersection, glm::vec3(0),
-                -ray_to_light.direction);
+                -ray_to_light.direction, sampler);
 
     // Factor based on angle.
     float cosine_component = glm::abs(glm::dot(ray_to_light.direction, intersection.normal));
@@ -71,14 +70,14 @@ glm::vec3 DirectLightingIntegrator::SampleLightPdf(Ray r, Intersection intersect
 // Helper function for computing the light energy at a point using a ray generated by bxdf.
 // Warning: intersections much be valid and light_intersection /must/ actually be an intersection with a light.
 
-glm::vec3 DirectLightingIntegrator::SampleBxdfPdf(Ray r, Intersection intersection, Geometry *light, float& pdf, glm::vec3& new_direction, glm::vec3& energy_back) {
+glm::vec3 DirectLightingIntegrator::SampleBxdfPdf(Ray r, Intersection intersection, Geometry *light, float& pdf, glm::vec3& new_direction, glm::vec3& energy_back, Sampler &sampler) {
 
     // Generate a ray from bxdf function.
     glm::vec3 bxdf_ray_direction;
     float bxdf_pdf;
 
     glm::vec3 energy = intersection.object_hit->material->SampleAndEvaluateScatteredEnergy(
-                intersection, -r.direction, bxdf_ray_direction, bxdf_pdf);
+                intersection, -r.direction, bxdf_ray_direction, bxdf_pdf, sampler);
 
     pdf = bxdf_pdf;
     new_direction = objectToWorldSpace(bxdf_ray_direction, intersection);
@@ -106,7 +105,7 @@ glm::vec3 DirectLightingIntegrator::SampleBxdfPdf(Ray r, Intersection intersecti
 
     // Energy scattered by intersected light material.
     glm::vec3 light_energy = light_intersection.object_hit->material->EvaluateScatteredEnergy(
-                light_intersection, glm::vec3(0), -ray_to_light.direction);
+                light_intersection, glm::vec3(0), -ray_to_light.direction, sampler);
 
     // Factor based on angle.
     float cosine_component = glm::abs(glm::dot(ray_to_light.direction, intersection.normal));
@@ -125,22 +124,23 @@ glm::vec3 DirectLightingIntegrator::SampleBxdfPdf(Ray r, Intersection intersecti
     return total_energy;
 }
 
-glm::vec3 DirectLightingIntegrator::ComputeDirectLighting(Ray r, const Intersection &intersection, float& pdf, glm::vec3& new_direction, glm::vec3& energy_back) {
-    // Choose a random light in the scene.
-    Geometry *light = scene->lights.at(rand() % scene->lights.size());
+glm::vec3 DirectLightingIntegrator::ComputeDirectLighting(Ray r, const Intersection &intersection, float& pdf, glm::vec3& new_direction, glm::vec3& energy_back, Sampler &sampler) {
+    // Choose a light in the scene, brighter lights more often.
+    float light_choice_pdf;
+    Geometry *light = scene->lights.at(scene->light_distribution.Sample(sampler.Get1D(), &light_choice_pdf));
 
     // Calculate light using sample to random point on random light.
-    glm::vec3 light_sample_value = SampleLightPdf(r, intersection, light);
+    glm::vec3 light_sample_value = SampleLightPdf(r, intersection, light, sampler);
 
     // Calculate light using sample generated from bxdf.
-    glm::vec3 brdf_sample_value = SampleBxdfPdf(r, intersection, light, pdf, new_direction, energy_back);
+    glm::vec3 brdf_sample_value = SampleBxdfPdf(r, intersection, light, pdf, new_direction, energy_back, sampler);
     //glm::vec3 brdf_sample_value = glm::vec3(0);
 
-    return (light_sample_value + brdf_sample_value) * float(scene->lights.size());
+    return (light_sample_value + brdf_sample_value) / light_choice_pdf;
 }
 
 
-glm::vec3 DirectLightingIntegrator::TraceRay(Ray r, unsigned int depth, int pixel_i, int pixel_j) {
+glm::vec3 DirectLightingIntegrator::TraceRay(Ray r, unsigned int depth, Sampler &sampler, AOVSample *aovs) {
     glm::vec3 color = glm::vec3(0.0f);
     // If recursion depth max hit, return black.
     if (depth > max_depth) {
@@ -148,7 +148,7 @@ glm::vec3 DirectLightingIntegrator::TraceRay(Ray r, unsigned int depth, int pixe
     }
 
     Intersection intersection = intersection_engine->GetIntersection(r);
-    scene->film.pixel_depths[pixel_i][pixel_j] = intersection.t / pow(scene->sqrt_samples, 2);
+    RecordAOVs(intersection, aovs);
     // If no object intersected or the object is in shadow, return black.
     if (!intersection.object_hit) {
         return color;
@@ -157,7 +157,7 @@ glm::vec3 DirectLightingIntegrator::TraceRay(Ray r, unsigned int depth, int pixe
     // If we hit a light, just return the color of the light * energy.
     if (intersection.object_hit->material->is_light_source) {
         return intersection.object_hit->material->base_color
-                *intersection.object_hit->material->EvaluateScatteredEnergy(intersection, glm::vec3(0), -r.direction);
+                *intersection.object_hit->material->EvaluateScatteredEnergy(intersection, glm::vec3(0), -r.direction, sampler);
     }
     float pdf; glm::vec3 new_direction, energy_back;
 
@@ -191,7 +191,7 @@ glm::vec3 DirectLightingIntegrator::TraceRay(Ray r, unsigned int depth, int pixe
 
     glm::vec3 unused_vec;
     float unused_float;
-    return ComputeDirectLighting(r, intersection, pdf, new_direction, energy_back);
+    return ComputeDirectLighting(r, intersection, pdf, new_direction, energy_back, sampler);
 //    return ComputeDirectLighting(r, intersection, unused_vec, unused_float);
 
 }
@@ -1,24 +1,286 @@
 #include <raytracing/film.h>
+#include <raytracing/filter.h>
 #include <bmp/EasyBMP.h>
+#include <limits>
+
+static float Luminance(const glm::vec3 &color)
+{
+    return glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+}
+
+FilmTile::FilmTile(unsigned int x_start, unsigned int x_end, unsigned int y_start, unsigned int y_end,
+                   const glm::vec2 &filter_radius, const std::vector<float> *filter_table, int filter_table_width)
+    : x_start(x_start), x_end(x_end), y_start(y_start), y_end(y_end),
+      pixels((x_end - x_start) * (y_end - y_start)), aovs(pixels.size()),
+      filter_radius(filter_radius), inv_filter_radius(1.0f / filter_radius),
+      filter_table(filter_table), filter_table_width(filter_table_width)
+{}
+
+FilmPixel& FilmTile::GetPixel(unsigned int x, unsigned int y)
+{
+    return pixels[(y - y_start) * (x_end - x_start) + (x - x_start)];
+}
+
+const FilmPixel& FilmTile::GetPixel(unsigned int x, unsigned int y) const
+{
+    return pixels[(y - y_start) * (x_end - x_start) + (x - x_start)];
+}
+
+void FilmTile::AddSample(const glm::vec2 &film_point, const glm::vec3 &radiance, const AOVSample *sample_aovs)
+{
+    //Pixel centers sit at half-integer coordinates; shift so they land on integers
+    glm::vec2 discrete_point = film_point - glm::vec2(0.5f);
+    int x0 = glm::max((int)ceilf(discrete_point.x - filter_radius.x), (int)x_start);
+    int x1 = glm::min((int)floorf(discrete_point.x + filter_radius.x) + 1, (int)x_end);
+    int y0 = glm::max((int)ceilf(discrete_point.y - filter_radius.y), (int)y_start);
+    int y1 = glm::min((int)floorf(discrete_point.y + filter_radius.y) + 1, (int)y_end);
+
+    //Look up the table offsets once per column and row instead of once per pixel.
+    //CreateFilter keeps the radius under 8, so a sample never reaches more than 17 pixels per axis.
+    int x_offsets[32], y_offsets[32];
+    for (int x = x0; x < x1; x++) {
+        float fx = fabsf((x - discrete_point.x) * inv_filter_radius.x * filter_table_width);
+        x_offsets[x - x0] = glm::min((int)fx, filter_table_width - 1);
+    }
+    for (int y = y0; y < y1; y++) {
+        float fy = fabsf((y - discrete_point.y) * inv_filter_radius.y * filter_table_width);
+        y_offsets[y - y0] = glm::min((int)fy, filter_table_width - 1);
+    }
+
+    const float *table = filter_table->data();
+    for (int y = y0; y < y1; y++) {
+        FilmPixel *row = &GetPixel(x0, y);
+        const float *table_row = table + y_offsets[y - y0] * filter_table_width;
+        for (int x = x0; x < x1; x++, row++) {
+            float weight = table_row[x_offsets[x - x0]];
+            row->weighted_radiance += radiance * weight;
+            row->weight += weight;
+        }
+    }
+
+    int x = (int)floorf(film_point.x), y = (int)floorf(film_point.y);
+    if (x >= (int)x_start && x < (int)x_end && y >= (int)y_start && y < (int)y_end) {
+        unsigned int index = (y - y_start) * (x_end - x_start) + (x - x_start);
+        if (sample_aovs) {
+            AOVSample &sum = aovs[index];
+            sum.depth += sample_aovs->depth;
+            sum.normal += sample_aovs->normal;
+            sum.albedo += sample_aovs->albedo;
+            if (pixels[index].sample_count == 0) {
+                sum.object_id = sample_aovs->object_id;
+            }
+        }
+        float luminance = Luminance(radiance);
+        pixels[index].luminance_sum += luminance;
+        pixels[index].luminance_squared_sum += luminance * luminance;
+        pixels[index].sample_count++;
+    }
+}
 
 Film::Film() : Film(400, 400){}
 
 Film::Film(unsigned int width, unsigned int height)
 {
     SetDimensions(width, height);
+    SetFilter(FILTER_BOX, 0.5f);
+}
+
+Film::Film(const Film &other)
+    : width(other.width), height(other.height), pixels(other.pixels), aovs(other.aovs), converged(other.converged),
+      filter_radius(other.filter_radius), filter_table(other.filter_table)
+{}
+
+Film& Film::operator=(const Film &other)
+{
+    width = other.width;
+    height = other.height;
+    pixels = other.pixels;
+    aovs = other.aovs;
+    converged = other.converged;
+    filter_radius = other.filter_radius;
+    filter_table = other.filter_table;
+    return *this;
 }
 
 void Film::SetDimensions(unsigned int w, unsigned int h)
 {
     this->width = w;
     this->height = h;
-    pixels.clear();
-    pixel_depths.clear();
-    pixels = std::vector<std::vector<glm::vec3>>(width);
-    pixel_depths = std::vector<std::vector<float>>(width);
-    for(unsigned int i = 0; i < width; i++){
-        pixels[i] = std::vector<glm::vec3>(height);
-        pixel_depths[i] = std::vector<float>(height);
+    pixels.assign(width * height, FilmPixel());
+    aovs.assign(width * height, AOVSample());
+    converged.assign(width * height, 0);
+}
+
+void Film::SetFilter(FilterType type, float radius)
+{
+    Filter* filter = CreateFilter(type, radius);
+    filter_radius = filter->radius;
+    filter_table.resize(FILTER_TABLE_WIDTH * FILTER_TABLE_WIDTH);
+    for (int y = 0; y < FILTER_TABLE_WIDTH; y++) {
+        for (int x = 0; x < FILTER_TABLE_WIDTH; x++) {
+            glm::vec2 p((x + 0.5f) * filter_radius.x / FILTER_TABLE_WIDTH,
+                        (y + 0.5f) * filter_radius.y / FILTER_TABLE_WIDTH);
+            filter_table[y * FILTER_TABLE_WIDTH + x] = filter->Evaluate(p);
+        }
+    }
+    delete filter;
+}
+
+void Film::Clear()
+{
+    std::fill(pixels.begin(), pixels.end(), FilmPixel());
+    std::fill(aovs.begin(), aovs.end(), AOVSample());
+    std::fill(converged.begin(), converged.end(), 0);
+}
+
+glm::vec3 Film::GetPixel(unsigned int x, unsigned int y) const
+{
+    const FilmPixel &pixel = pixels[y * width + x];
+    if (pixel.weight == 0.0f) {
+        return glm::vec3(0.0f);
+    }
+    return pixel.weighted_radiance / pixel.weight;
+}
+
+void Film::SetPixel(unsigned int x, unsigned int y, const glm::vec3 &color)
+{
+    FilmPixel &pixel = pixels[y * width + x];
+    pixel.weighted_radiance = color;
+    pixel.weight = 1.0f;
+}
+
+void Film::GetPixels(unsigned int x_start, unsigned int x_end, unsigned int y_start, unsigned int y_end, glm::vec3 *colors)
+{
+    std::lock_guard<std::mutex> guard(merge_lock);
+    for (unsigned int y = y_start; y < y_end; y++) {
+        for (unsigned int x = x_start; x < x_end; x++) {
+            *colors++ = GetPixel(x, y);
+        }
+    }
+}
+
+float Film::EstimateRelativeError(unsigned int x, unsigned int y) const
+{
+    const FilmPixel &pixel = pixels[y * width + x];
+    if (pixel.sample_count < 2) {
+        return std::numeric_limits<float>::infinity();
+    }
+    float n = pixel.sample_count;
+    float mean = pixel.luminance_sum / n;
+    float variance = glm::max((pixel.luminance_squared_sum - pixel.luminance_sum * mean) / (n - 1.0f), 0.0f);
+    // Near-black pixels would otherwise never count as converged.
+    return sqrtf(variance / n) / glm::max(mean, 0.01f);
+}
+
+float Film::EstimateNoise() const
+{
+    double error_sum = 0.0;
+    for (unsigned int y = 0; y < height; y++) {
+        for (unsigned int x = 0; x < width; x++) {
+            error_sum += EstimateRelativeError(x, y);
+        }
+    }
+    return error_sum / (width * height);
+}
+
+unsigned int Film::MarkConvergedPixels(float threshold, unsigned int min_samples)
+{
+    unsigned int active = 0;
+    for (unsigned int y = 0; y < height; y++) {
+        for (unsigned int x = 0; x < width; x++) {
+            unsigned int index = y * width + x;
+            if (converged[index]) {
+                continue;
+            }
+            if (pixels[index].sample_count >= min_samples && EstimateRelativeError(x, y) < threshold) {
+                converged[index] = 1;
+            } else {
+                active++;
+            }
+        }
+    }
+    return active;
+}
+
+bool Film::IsConverged(unsigned int x, unsigned int y) const
+{
+    return converged[y * width + x] != 0;
+}
+
+void Film::AddPixelAOVs(unsigned int x, unsigned int y, const AOVSample &sample)
+{
+    FilmPixel &pixel = pixels[y * width + x];
+    AOVSample &sum = aovs[y * width + x];
+    sum.depth += sample.depth;
+    sum.normal += sample.normal;
+    sum.albedo += sample.albedo;
+    if (pixel.sample_count == 0) {
+        sum.object_id = sample.object_id;
+    }
+    pixel.sample_count++;
+}
+
+float Film::GetDepth(unsigned int x, unsigned int y) const
+{
+    unsigned int count = pixels[y * width + x].sample_count;
+    return count ? aovs[y * width + x].depth / count : 0.0f;
+}
+
+glm::vec3 Film::GetNormal(unsigned int x, unsigned int y) const
+{
+    unsigned int count = pixels[y * width + x].sample_count;
+    return count ? aovs[y * width + x].normal / (float)count : glm::vec3(0.0f);
+}
+
+glm::vec3 Film::GetAlbedo(unsigned int x, unsigned int y) const
+{
+    unsigned int count = pixels[y * width + x].sample_count;
+    return count ? aovs[y * width + x].albedo / (float)count : glm::vec3(0.0f);
+}
+
+int Film::GetObjectID(unsigned int x, unsigned int y) const
+{
+    return aovs[y * width + x].object_id;
+}
+
+unsigned int Film::GetSampleCount(unsigned int x, unsigned int y) const
+{
+    return pixels[y * width + x].sample_count;
+}
+
+FilmTile Film::GetFilmTile(unsigned int x_start, unsigned int x_end, unsigned int y_start, unsigned int y_end) const
+{
+    //Samples in the tile lie in [start, end), so their discrete positions lie in [start - 0.5, end - 0.5)
+    int x0 = glm::max((int)ceilf(x_start - 0.5f - filter_radius.x), 0);
+    int x1 = glm::min((int)floorf(x_end - 0.5f + filter_radius.x) + 1, (int)width);
+    int y0 = glm::max((int)ceilf(y_start - 0.5f - filter_radius.y), 0);
+    int y1 = glm::min((int)floorf(y_end - 0.5f + filter_radius.y) + 1, (int)height);
+    return FilmTile(x0, x1, y0, y1, filter_radius, &filter_table, FILTER_TABLE_WIDTH);
+}
+
+void Film::MergeFilmTile(const FilmTile &tile)
+{
+    std::lock_guard<std::mutex> guard(merge_lock);
+    const FilmPixel *tile_pixel = tile.pixels.data();
+    const AOVSample *tile_aovs = tile.aovs.data();
+    for (unsigned int y = tile.y_start; y < tile.y_end; y++) {
+        FilmPixel *row = &pixels[y * width + tile.x_start];
+        AOVSample *aov_row = &aovs[y * width + tile.x_start];
+        for (unsigned int x = tile.x_start; x < tile.x_end; x++, row++, tile_pixel++, aov_row++, tile_aovs++) {
+            if (tile_pixel->sample_count != 0) {
+                aov_row->depth += tile_aovs->depth;
+                aov_row->normal += tile_aovs->normal;
+                aov_row->albedo += tile_aovs->albedo;
+                if (row->sample_count == 0) {
+                    aov_row->object_id = tile_aovs->object_id;
+                }
+            }
+            row->weighted_radiance += tile_pixel->weighted_radiance;
+            row->weight += tile_pixel->weight;
+            row->sample_count += tile_pixel->sample_count;
+            row->luminance_sum += tile_pixel->luminance_sum;
+            row->luminance_squared_sum += tile_pixel->luminance_squared_sum;
+        }
     }
 }
 
@@ -35,9 +297,9 @@ void Film::WriteImage(const std::string &path){
     output.SetSize(width, height);
     output.SetBitDepth(24);
 
-    for(unsigned int i = 0; i < width; i++) {
-        for(unsigned int j = 0; j < height; j++) {
-            glm::vec3 color = pixels[i][j];
+    for(unsigned int j = 0; j < height; j++) {
+        for(unsigned int i = 0; i < width; i++) {
+            glm::vec3 color = GetPixel(i, j);
             output(i, j)->Red   = glm::clamp(color.r, 0.0f, 1.0f)*255;
             output(i, j)->Green = glm::clamp(color.g, 0.0f, 1.0f)*255;
             output(i, j)->Blue  = glm::clamp(color.b, 0.0f, 1.0f)*255;
@@ -45,3 +307,23 @@ void Film::WriteImage(const std::string &path){
     }
     output.WriteToFile(path.c_str());
 }
+
+void Film::WriteSampleCountImage(const std::string &path){
+    unsigned int max_count = 1;
+    for(const FilmPixel &pixel : pixels) {
+        max_count = glm::max(max_count, pixel.sample_count);
+    }
+
+    BMP output;
+    output.SetSize(width, height);
+    output.SetBitDepth(24);
+    for(unsigned int j = 0; j < height; j++) {
+        for(unsigned int i = 0; i < width; i++) {
+            ebmpBYTE level = 255.0f * GetSampleCount(i, j) / max_count;
+            output(i, j)->Red   = level;
+            output(i, j)->Green = level;
+            output(i, j)->Blue  = level;
+        }
+    }
+    output.WriteToFile(path.c_str());
+}
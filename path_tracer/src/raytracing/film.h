@@ -1,16 +1,113 @@
 #pragma once
 #include <la.h>
+#include <raytracing/renderoptions.h>
 #include <vector>
+#include <mutex>
+
+//What the film accumulates for one pixel. The pixel's color is weighted_radiance / weight.
+struct FilmPixel {
+    FilmPixel() : weighted_radiance(0.0f), weight(0.0f), sample_count(0), luminance_sum(0.0f), luminance_squared_sum(0.0f) {}
+    glm::vec3 weighted_radiance;    //Sum of every sample's radiance times its filter weight.
+    float weight;                   //Sum of the filter weights. Can be negative with the Mitchell filter.
+    unsigned int sample_count;      //Samples that landed inside this pixel.
+    //Unweighted sums over the samples inside this pixel, for estimating how noisy it still is.
+    float luminance_sum, luminance_squared_sum;
+};
+
+//The auxiliary values (AOVs) of one camera sample, taken from the first surface it hits.
+//Denoisers and adaptive sampling read these back from the film per pixel.
+struct AOVSample {
+    AOVSample() : depth(0.0f), normal(0.0f), albedo(0.0f), object_id(-1) {}
+    float depth;        //Distance along the camera ray, or 0 if it hit nothing.
+    glm::vec3 normal;   //World space surface normal.
+    glm::vec3 albedo;   //Material color times texture color.
+    int object_id;      //Index of the object hit in the scene's list of objects, or -1.
+};
+
+//A render thread's private copy of the pixels a tile's samples can reach, so adding samples needs no
+//locking. Its bounds are the tile's grown by the filter radius and clipped to the film.
+class FilmTile{
+public:
+    FilmTile(unsigned int x_start, unsigned int x_end, unsigned int y_start, unsigned int y_end,
+             const glm::vec2 &filter_radius, const std::vector<float> *filter_table, int filter_table_width);
+    //Splats a sample at film_point, in pixels, onto every pixel whose filter covers it.
+    //Its AOVs, if given, are only added to the pixel that contains film_point.
+    void AddSample(const glm::vec2 &film_point, const glm::vec3 &radiance, const AOVSample *aovs = NULL);
+    FilmPixel& GetPixel(unsigned int x, unsigned int y);
+    const FilmPixel& GetPixel(unsigned int x, unsigned int y) const;
+
+    unsigned int x_start, x_end, y_start, y_end;
+    std::vector<FilmPixel> pixels;//Row-major over [x_start, x_end) x [y_start, y_end)
+    std::vector<AOVSample> aovs;//Summed per pixel in the same layout; object_id is the first sample's
+
+private:
+    glm::vec2 filter_radius, inv_filter_radius;
+    const std::vector<float> *filter_table;
+    int filter_table_width;
+};
 
 class Film{
 public:
     Film();
     Film(unsigned int width, unsigned int height);
+    //The merge lock isn't copied; the copy gets its own
+    Film(const Film &other);
+    Film& operator=(const Film &other);
     unsigned int width, height;
-    std::vector<std::vector<glm::vec3>> pixels;//A 2D array of pixels in which we can store colors
-    std::vector<std::vector<float>> pixel_depths; // A 2D array of approxiamte z values at each pixel.
+    std::vector<FilmPixel> pixels;//Row-major: pixel (x, y) is at y * width + x
+    //AOVs summed over the samples inside each pixel, in the same layout. object_id is the first sample's.
+    std::vector<AOVSample> aovs;
+    //Nonzero for pixels that adaptive sampling has stopped, in the same layout.
+    std::vector<unsigned char> converged;
 
     void SetDimensions(unsigned int w, unsigned int h);
+    //Tabulates the filter that tiles weight their samples by. Takes effect for tiles made after the call.
+    void SetFilter(FilterType type, float radius);
+    //Throws away every accumulated sample and AOV.
+    void Clear();
+
+    //The filtered color of a pixel, or black if nothing has reached it.
+    glm::vec3 GetPixel(unsigned int x, unsigned int y) const;
+    //Replaces everything accumulated at a pixel with one fully weighted color.
+    void SetPixel(unsigned int x, unsigned int y, const glm::vec3 &color);
+    //Adds one sample's AOVs to a pixel, for renders that don't go through tiles. Not thread safe.
+    void AddPixelAOVs(unsigned int x, unsigned int y, const AOVSample &sample);
+
+    //Copies the filtered colors of [x_start, x_end) x [y_start, y_end) into colors, row by row. Safe to
+    //call while tiles are being merged.
+    void GetPixels(unsigned int x_start, unsigned int x_end, unsigned int y_start, unsigned int y_end, glm::vec3 *colors);
+
+    //The standard error of a pixel's mean luminance relative to that mean. Infinite below two samples.
+    float EstimateRelativeError(unsigned int x, unsigned int y) const;
+    //The relative error averaged over every pixel, as a measure of how converged the image is.
+    float EstimateNoise() const;
+    //Marks every pixel with at least min_samples samples and a relative error below threshold as
+    //converged. Call it between passes only. Returns how many pixels are still unconverged.
+    unsigned int MarkConvergedPixels(float threshold, unsigned int min_samples);
+    bool IsConverged(unsigned int x, unsigned int y) const;
+
+    //The AOVs averaged over the samples inside a pixel, or their defaults if there are none.
+    float GetDepth(unsigned int x, unsigned int y) const;
+    glm::vec3 GetNormal(unsigned int x, unsigned int y) const;
+    glm::vec3 GetAlbedo(unsigned int x, unsigned int y) const;
+    int GetObjectID(unsigned int x, unsigned int y) const;
+    unsigned int GetSampleCount(unsigned int x, unsigned int y) const;
+
+    //Makes an empty tile covering every pixel the samples of [x_start, x_end) x [y_start, y_end) can reach.
+    FilmTile GetFilmTile(unsigned int x_start, unsigned int x_end, unsigned int y_start, unsigned int y_end) const;
+    //Adds a tile's sums into the film. Neighbouring tiles overlap by the filter radius, so this locks.
+    void MergeFilmTile(const FilmTile &tile);
+
     void WriteImage(const std::string &path);
     void WriteImage(QString path);
+    //Writes each pixel's sample count as a gray level, white being the largest count in the image.
+    void WriteSampleCountImage(const std::string &path);
+
+private:
+    //The filter is evaluated on a grid over one quadrant of its support; it is symmetric.
+    static const int FILTER_TABLE_WIDTH = 16;
+
+    glm::vec2 filter_radius;
+    std::vector<float> filter_table;
+    std::mutex merge_lock;
 };
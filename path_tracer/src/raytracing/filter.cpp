@@ -0,0 +1,72 @@
+#include <raytracing/filter.h>
+
+Filter::Filter(const glm::vec2 &radius) : radius(radius)
+{}
+
+BoxFilter::BoxFilter(const glm::vec2 &radius) : Filter(radius)
+{}
+
+float BoxFilter::Evaluate(const glm::vec2 &) const
+{
+    return 1.0f;
+}
+
+TentFilter::TentFilter(const glm::vec2 &radius) : Filter(radius)
+{}
+
+float TentFilter::Evaluate(const glm::vec2 &p) const
+{
+    return glm::max(0.0f, radius.x - fabsf(p.x)) * glm::max(0.0f, radius.y - fabsf(p.y));
+}
+
+GaussianFilter::GaussianFilter(const glm::vec2 &radius, float alpha) :
+    Filter(radius), alpha(alpha),
+    exp_radius(expf(-alpha * radius.x * radius.x), expf(-alpha * radius.y * radius.y))
+{}
+
+float GaussianFilter::Gaussian(float d, float exp_radius) const
+{
+    return glm::max(0.0f, expf(-alpha * d * d) - exp_radius);
+}
+
+float GaussianFilter::Evaluate(const glm::vec2 &p) const
+{
+    return Gaussian(p.x, exp_radius.x) * Gaussian(p.y, exp_radius.y);
+}
+
+MitchellFilter::MitchellFilter(const glm::vec2 &radius, float B, float C) :
+    Filter(radius), B(B), C(C)
+{}
+
+//x is in [-1, 1], the filter's support scaled to the cubic's [-2, 2].
+float MitchellFilter::Mitchell1D(float x) const
+{
+    x = fabsf(2.0f * x);
+    if (x > 1.0f) {
+        return ((-B - 6 * C) * x * x * x + (6 * B + 30 * C) * x * x +
+                (-12 * B - 48 * C) * x + (8 * B + 24 * C)) * (1.0f / 6.0f);
+    }
+    return ((12 - 9 * B - 6 * C) * x * x * x + (-18 + 12 * B + 6 * C) * x * x +
+            (6 - 2 * B)) * (1.0f / 6.0f);
+}
+
+float MitchellFilter::Evaluate(const glm::vec2 &p) const
+{
+    return Mitchell1D(p.x / radius.x) * Mitchell1D(p.y / radius.y);
+}
+
+Filter* CreateFilter(FilterType type, float radius)
+{
+    //Below half a pixel some pixels would get no samples; the film's tiles assume at most 8
+    glm::vec2 r(glm::clamp(radius, 0.5f, 8.0f));
+    switch (type) {
+    case FILTER_TENT:
+        return new TentFilter(r);
+    case FILTER_GAUSSIAN:
+        return new GaussianFilter(r);
+    case FILTER_MITCHELL:
+        return new MitchellFilter(r);
+    default:
+        return new BoxFilter(r);
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <la.h>
+#include <raytracing/renderoptions.h>
+
+//A pixel reconstruction filter. The film weights each sample by the filter evaluated at the sample's
+//offset from a pixel center, for every pixel within radius of the sample.
+class Filter
+{
+public:
+    Filter(const glm::vec2 &radius);
+    virtual ~Filter(){}
+    //p is an offset from the pixel center, inside [-radius, radius].
+    virtual float Evaluate(const glm::vec2 &p) const = 0;
+
+    glm::vec2 radius;
+};
+
+class BoxFilter : public Filter
+{
+public:
+    BoxFilter(const glm::vec2 &radius);
+    virtual float Evaluate(const glm::vec2 &p) const;
+};
+
+//Falls off linearly from the center to zero at the radius.
+class TentFilter : public Filter
+{
+public:
+    TentFilter(const glm::vec2 &radius);
+    virtual float Evaluate(const glm::vec2 &p) const;
+};
+
+//A Gaussian shifted down so it reaches zero at the radius.
+class GaussianFilter : public Filter
+{
+public:
+    GaussianFilter(const glm::vec2 &radius, float alpha = 2.0f);
+    virtual float Evaluate(const glm::vec2 &p) const;
+
+protected:
+    float Gaussian(float d, float exp_radius) const;
+
+    float alpha;
+    glm::vec2 exp_radius;   //The unshifted Gaussian's value at the radius.
+};
+
+//Mitchell and Netravali's cubic. Its negative lobes sharpen edges; B = C = 1/3 is their recommendation.
+class MitchellFilter : public Filter
+{
+public:
+    MitchellFilter(const glm::vec2 &radius, float B = 1.0f / 3.0f, float C = 1.0f / 3.0f);
+    virtual float Evaluate(const glm::vec2 &p) const;
+
+protected:
+    float Mitchell1D(float x) const;
+
+    float B, C;
+};
+
+//Makes a filter of the given type with the same radius on both axes, clamped to [0.5, 8] pixels. The caller owns it.
+Filter* CreateFilter(FilterType type, float radius);
@@ -14,11 +14,23 @@ Integrator::Integrator(Scene *s):
     intersection_engine = NULL;
 }
 
-glm::vec3 Integrator::TraceRay(Ray r, unsigned int depth, int pixel_i, int pixel_j)
+glm::vec3 Integrator::TraceRay(Ray r, unsigned int depth, Sampler &, AOVSample *)
 {
     return glm::vec3(0.f);
 }
 
+void Integrator::RecordAOVs(const Intersection &isx, AOVSample *aovs) const
+{
+    if(aovs == NULL || isx.object_hit == NULL)
+    {
+        return;
+    }
+    aovs->depth = isx.t;
+    aovs->normal = isx.normal;
+    aovs->albedo = isx.object_hit->material->base_color * isx.texture_color;
+    aovs->object_id = isx.object_hit->id;
+}
+
 void Integrator::SetDepth(unsigned int depth)
 {
     max_depth = depth;
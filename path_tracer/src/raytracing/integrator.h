@@ -5,6 +5,7 @@
 #include <raytracing/intersectionengine.h>
 #include <scene/scene.h>
 #include <helpers.h>
+#include <raytracing/samplers/sampler.h>
 
 class Scene;
 
@@ -19,12 +20,18 @@ public:
     Integrator();
     Integrator(Scene *s);
     void SetDepth(unsigned int depth);
-    virtual glm::vec3 TraceRay(Ray r, unsigned int depth, int pixel_i, int pixel_j);
+    //sampler belongs to the calling render thread and has been started for the sample being traced.
+    //Every random number an integrator or material needs is drawn from it.
+    //aovs is only given for camera rays, and is filled in from the first surface the ray hits
+    virtual glm::vec3 TraceRay(Ray r, unsigned int depth, Sampler &sampler, AOVSample *aovs = NULL);
 
     Scene* scene;
     IntersectionEngine* intersection_engine;
 
 protected:
+    //Fills in aovs from a camera ray's first intersection. Does nothing if aovs is NULL
+    void RecordAOVs(const Intersection &isx, AOVSample *aovs) const;
+
     unsigned int max_depth;//Default value is 5.
 };
 
@@ -21,11 +21,40 @@ IntersectionEngine::IntersectionEngine()
 {
     scene = NULL;
     bvh = NULL;
+    use_wide_bvh = false;
+}
+
+void IntersectionEngine::BuildBVH(const BVHBuildOptions &options)
+{
+    bvh = bvhNode::InitTree(scene->objects, options);
+    linear_bvh.Flatten(bvh);
+    use_wide_bvh = options.branching_factor > 2;
+    if(use_wide_bvh)
+    {
+        wide_bvh.Collapse(linear_bvh, options.branching_factor);
+    }
+    else
+    {
+        wide_bvh.Clear();
+    }
 }
 
 Intersection IntersectionEngine::GetIntersection(Ray r) const
 {
-    return bvh->GetIntersection(r, scene->camera);
+    if(use_wide_bvh)
+    {
+        return wide_bvh.GetIntersection(r);
+    }
+    return linear_bvh.GetIntersection(r);
+}
+
+bool IntersectionEngine::Occluded(Ray r, float t_max) const
+{
+    if(use_wide_bvh)
+    {
+        return wide_bvh.Occluded(r, t_max);
+    }
+    return linear_bvh.Occluded(r, t_max);
 }
 
 QList<Intersection> IntersectionEngine::GetAllIntersections(Ray r)
@@ -33,7 +62,7 @@ QList<Intersection> IntersectionEngine::GetAllIntersections(Ray r)
     QList<Intersection> result;
     for(Geometry* g : scene->objects)
     {
-        Intersection isx = g->GetIntersection(r, scene->camera);
+        Intersection isx = g->GetIntersection(r);
         if(isx.t > 0)
         {
             result.append(isx);
@@ -2,6 +2,8 @@
 #include <QList>
 #include <raytracing/intersection.h>
 #include <scene/geometry/boundingbox.h>
+#include <scene/geometry/linearbvh.h>
+#include <scene/geometry/widebvh.h>
 #include <raytracing/ray.h>
 #include <scene/scene.h>
 
@@ -14,9 +16,18 @@ class IntersectionEngine
 {
 public:
     IntersectionEngine();
+    //Builds bvh over the scene's objects, then the structure rays are traced through: linear_bvh,
+    //or wide_bvh when options ask for a branching factor above 2.
+    void BuildBVH(const BVHBuildOptions &options);
     Intersection GetIntersection(Ray r) const;
+    //Any-hit query for shadow rays: returns true as soon as something blocks the ray before t_max.
+    //Transmissive objects are treated as not blocking.
+    bool Occluded(Ray r, float t_max) const;
     QList<Intersection> GetAllIntersections(Ray r);
 
     Scene *scene;
-    bvhNode *bvh;
+    bvhNode *bvh;           //Kept for drawing the tree in OpenGL
+    LinearBVH linear_bvh;   //Flattened copy of bvh that rays are traced against
+    WideBVH wide_bvh;       //linear_bvh collapsed to 4 or 8 children per node
+    bool use_wide_bvh;      //Trace rays through wide_bvh instead of linear_bvh
 };
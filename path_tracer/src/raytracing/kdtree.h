@@ -2,93 +2,78 @@
 
 #include <la.h>
 #include <vector>
-#include <scene/geometry/boundingbox.h>
-
-struct KdNode
-{
-    KdNode(float po, int a, int pa)
-    {
-        split_pos = po;
-        split_axis = a;
-        left = -1;
-        right = -1;
-        parent = pa;
-    }
-
-    float split_pos;
-    int split_axis;
-    int left;
-    int right;
-    int parent;
-};
+#include <algorithm>
+#include <raytracing/neighborlookup.h>
 
+//A kd-tree over any type with a glm::vec3 position, such as Photon. The nodes are stored in one
+//left-balanced array (Jensen, "Realistic Image Synthesis Using Photon Mapping"): the children of node i
+//are nodes 2i+1 and 2i+2, so the tree needs no pointers and a search walks a single contiguous buffer.
 template <typename NodeData>
-class KdTree
+class KdTree : public NeighborLookup<NodeData>
 {
 public:
-    KdTree(std::vector<NodeData> &data);
+    using NeighborLookup<NodeData>::MAX_NEIGHBORS;
+
+    KdTree();
+    KdTree(const std::vector<NodeData> &data);
 
-    // Search for nearest neighbors
-    int LookUp(const glm::vec3& position,
-            int& neighbor_num,
-            float& max_dist,
-            std::vector<NodeData>& out_neighbors) const;
+    virtual int LookUp(const glm::vec3& position,
+            int neighbor_num,
+            float max_dist,
+            const NodeData** out_neighbors,
+            float* out_radius2 = NULL) const;
+
+    virtual unsigned int Size() const;
+    virtual const NodeData& At(unsigned int index) const;
 
 private:
+    typedef typename NeighborLookup<NodeData>::Neighbor Neighbor;
+
     void CreateTreeRecursive(
             std::vector<NodeData> &build_data,
             unsigned int node_index,
             unsigned int start,
-            unsigned int end,
-            unsigned int parent
+            unsigned int end
             );
 
-    int LookUpPrivate(const glm::vec3& position,
-            int& neighbor_num,
-            int start_idx,
-            float& max_dist,
-            std::vector<NodeData>& out_neighbors) const;
-
-
-    // Search return index of the leaf node where given point should be inserted.
-    unsigned int Search(
-            const glm::vec3 &position,
-            int node_idx) const;
+    // The number of nodes in the left subtree of a left-balanced tree with node_count nodes.
+    static unsigned int LeftSubtreeSize(unsigned int node_count);
 
-    // List of kdNodes to keep track of split dimension
-    std::vector<KdNode*> kd_nodes;
-
-    // List od dataNodes to keep track of the actual data
-    std::vector<NodeData> data_nodes;
-
-    // Keep track of the next free index for kd_nodes and data_nodes
-    unsigned int next_free_index;
+    std::vector<NodeData> nodes;
+    std::vector<unsigned char> split_axes;
 };
 
-// For comparing using n_th element
 template <typename NodeData>
-struct CompareData {
-    CompareData(int a) {
-        axis = a;
-    }
-    int axis;
-    bool operator()(const NodeData a, const NodeData b) const {
-        return a.position[axis] < b.position[axis];
+KdTree<NodeData>::KdTree()
+{}
+
+template <typename NodeData>
+KdTree<NodeData>::KdTree(const std::vector<NodeData> &data) :
+    nodes(data.size()), split_axes(data.size(), 0)
+{
+    if (data.empty()) {
+        return;
     }
-};
+    // The build reorders its input, so it works on a copy.
+    std::vector<NodeData> build_data(data);
+    CreateTreeRecursive(build_data, 0, 0, build_data.size());
+}
 
 template <typename NodeData>
-KdTree<NodeData>::KdTree(std::vector<NodeData> &data)
+unsigned int KdTree<NodeData>::LeftSubtreeSize(unsigned int node_count)
 {
-    if (data.size() == 0) {
-        next_free_index = 1;
-    } else {
-        next_free_index = 1;
-        kd_nodes = std::vector<KdNode*>(data.size());
-        data_nodes = std::vector<NodeData>(data.size());
-
-        CreateTreeRecursive(data, 0, 0, data.size(), 0);
+    if (node_count <= 1) {
+        return 0;
+    }
+    // Find the largest complete tree that fits, then hand the nodes of the last, partial level to the
+    // left subtree until its half of that level is full.
+    unsigned int complete_size = 1;
+    while (2 * complete_size + 1 <= node_count) {
+        complete_size = 2 * complete_size + 1;
     }
+    unsigned int last_level_count = node_count - complete_size;
+    unsigned int half_last_level = (complete_size + 1) / 2;
+    return (complete_size - 1) / 2 + glm::min(last_level_count, half_last_level);
 }
 
 template <typename NodeData>
@@ -96,156 +81,109 @@ void KdTree<NodeData>::CreateTreeRecursive(
         std::vector<NodeData>& build_data,
         unsigned int node_index,
         unsigned int start,
-        unsigned int end,
-        unsigned int parent
+        unsigned int end
         )
 {
-    if (start + 1 == end) {
-        // Get to leaf node, initialize data_nodes
-        kd_nodes[node_index] = new KdNode(0.f, 0, parent);
-        data_nodes[node_index] = build_data[start];
-    }
-
-    // Compute bound of points
-    BoundingBox bound;
-    for (unsigned int i = start; i < end; i++)
+    // Split along the axis the points are most spread out on.
+    glm::vec3 min_point = build_data[start].position;
+    glm::vec3 max_point = min_point;
+    for (unsigned int i = start + 1; i < end; i++)
     {
-        bound = BoundingBox::Union(bound, build_data[i].position);
+        min_point = glm::min(min_point, build_data[i].position);
+        max_point = glm::max(max_point, build_data[i].position);
     }
+    glm::vec3 extent = max_point - min_point;
+    int split_axis = (extent.x > extent.y && extent.x > extent.z) ? 0 : (extent.y > extent.z ? 1 : 2);
 
-    // Partial sort all points less than to the left and greater than to the right
-    unsigned int split_axis = bound.MaximumExtent();
-    unsigned int split_pos = (start + end) / 2;
-    std::nth_element(&build_data[start], &build_data[split_pos], &build_data[end], CompareData<NodeData>(split_axis));
+    // Partial sort so the points left of the median have the smaller coordinates.
+    unsigned int split_pos = start + LeftSubtreeSize(end - start);
+    std::nth_element(build_data.begin() + start, build_data.begin() + split_pos, build_data.begin() + end,
+                     [split_axis](const NodeData &a, const NodeData &b) {
+        return a.position[split_axis] < b.position[split_axis];
+    });
 
-    // Initialize this node
-    kd_nodes[node_index] = new KdNode(build_data[split_pos].position[split_axis], split_axis, parent);
-    data_nodes[node_index] = build_data[split_pos];
+    nodes[node_index] = build_data[split_pos];
+    split_axes[node_index] = split_axis;
 
     if (start < split_pos) {
-        // Build left branch
-        int left_index = next_free_index++;
-        kd_nodes[node_index]->left = left_index;
-        CreateTreeRecursive(build_data, left_index, start, split_pos, node_index);
+        CreateTreeRecursive(build_data, 2 * node_index + 1, start, split_pos);
     }
-
     if (split_pos + 1 < end) {
-        // Build right branch
-        int right_index = next_free_index++;
-        kd_nodes[node_index]->left = right_index;
-        CreateTreeRecursive(build_data, right_index, split_pos + 1, end, node_index);
-    }
-}
-
-
-template <typename NodeData>
-unsigned int KdTree<NodeData>::Search(
-        const glm::vec3 &position,
-        int node_idx) const {
-    // Shouldn't happen.
-    if (node_idx == -1) {
-        return -1;
+        CreateTreeRecursive(build_data, 2 * node_index + 2, split_pos + 1, end);
     }
-
-    // Get the node at the current index.
-    KdNode *curr = kd_nodes[node_idx];
-
-    // Check if position is to the left of the split plane.
-    if (position[curr->split_axis] < curr->split_pos && curr->left != -1) {
-        // Recursively search left sub-tree.
-        return Search(position, curr->left);
-    } else if (position[curr->split_axis] > curr->split_pos && curr->right != -1) {
-        return Search(position, curr->right);
-    }
-    return node_idx;
 }
 
 template <typename NodeData>
 int KdTree<NodeData>::LookUp(
         const glm::vec3& position,
-        int& neighbor_num,
-        float& max_dist,
-        std::vector<NodeData>& out_neighbors
+        int neighbor_num,
+        float max_dist,
+        const NodeData** out_neighbors,
+        float* out_radius2
         ) const
 {
-    if (data_nodes.size() == 0)
+    neighbor_num = glm::min(neighbor_num, int(MAX_NEIGHBORS));
+    if (nodes.empty() || neighbor_num <= 0)
     {
         return 0;
     }
-    return LookUpPrivate(position, neighbor_num, 0, max_dist, out_neighbors);
-}
-
-template <typename NodeData>
-int KdTree<NodeData>::LookUpPrivate(
-        const glm::vec3& position,
-        int& neighbor_num,
-        int start_idx,
-        float& max_dist,
-        std::vector<NodeData>& out_neighbors
-        ) const
-{
-    // Vector containing k best distance.
-    std::vector<float> distances;
-    // Vector containing k best nodes (index parallel to "distances").
-    std::vector<int> node_indicies;
-
-    // Begin by searching for appropriate place in the tree.
-    int curr_idx = Search(position, start_idx);
-
-    // Get distance from position.
-    float distance = glm::distance2(data_nodes[curr_idx].position, position);
-    if (distance < max_dist) {
-        distances.push_back(distance);
-        node_indicies.push_back(curr_idx);
-    }
-
-    while (curr_idx > 0) {
-        // Get parent.
-        KdNode *parent = kd_nodes[kd_nodes[curr_idx]->parent];
-
-        // Check if parent should be inserted into candidate list.
-        float tmp_distance = glm::distance2(data_nodes[kd_nodes[curr_idx]->parent].position, position);
 
-        int insert_idx = 0;
-        while (distances.size() && tmp_distance > distances[insert_idx]) {
-            ++insert_idx;
-        }
-
-        if (insert_idx < neighbor_num &&
-                insert_idx < node_indicies.size() &&
-                tmp_distance < max_dist
-                )
-        {
-            // If the distance should be inserted before index k, it belongs in the list.
-            distances.insert(distances.begin() + insert_idx, 1, tmp_distance);
-            node_indicies.insert(node_indicies.begin() + insert_idx, 1, kd_nodes[curr_idx]->parent);
-        }
+    Neighbor heap[MAX_NEIGHBORS];
+    int heap_size = 0;
+    // Shrinks to the distance of the farthest neighbor once neighbor_num have been found.
+    float radius2 = max_dist * max_dist;
+
+    // Subtrees on the far side of a split plane, with the squared distance to that plane. A node is
+    // pushed at most once per level, so the stack never holds more entries than the tree is deep.
+    struct FarSubtree { unsigned int index; float plane_distance2; };
+    FarSubtree stack[64];
+    int stack_size = 0;
+
+    unsigned int node_count = nodes.size();
+    unsigned int node_index = 0;
+    while (true) {
+        // Walk down to a leaf, always taking the side of the plane position lies on.
+        while (node_index < node_count) {
+            const glm::vec3 &node_position = nodes[node_index].position;
+            float distance2 = glm::distance2(node_position, position);
+            if (distance2 < radius2) {
+                Neighbor candidate = { distance2, node_index };
+                this->PushNeighbor(heap, heap_size, neighbor_num, candidate);
+                if (heap_size == neighbor_num) {
+                    radius2 = heap[0].distance2;
+                }
+            }
 
-        while (node_indicies.size() >= neighbor_num) {
-            distances.pop_back();
-            node_indicies.pop_back();
+            float plane_offset = position[split_axes[node_index]] - node_position[split_axes[node_index]];
+            unsigned int near_child = 2 * node_index + (plane_offset < 0.f ? 1 : 2);
+            unsigned int far_child = 2 * node_index + (plane_offset < 0.f ? 2 : 1);
+            float plane_distance2 = plane_offset * plane_offset;
+            if (far_child < node_count && plane_distance2 < radius2) {
+                FarSubtree far = { far_child, plane_distance2 };
+                stack[stack_size++] = far;
+            }
+            node_index = near_child;
         }
 
-        // Check if the sphere of radius position to kth candidate intersects the split plane.
-        // If the plane intersects or we have less than k candidates, traverse other subtree.
-        if (distances.size() && distances.back() > (parent->split_pos - position[parent->split_axis])
-                || distances.size() < neighbor_num) {
-            // Check whether should go down left or right subtree
-            if (curr_idx == parent->left && parent->right != -1) {
-                // Go right.
-                LookUpPrivate(position, neighbor_num, parent->right, max_dist, out_neighbors);
-            } else if (curr_idx == parent->right && parent->left != -1) {
-                // Go left.
-                LookUpPrivate(position, neighbor_num, parent->left, max_dist, out_neighbors);
+        // Resume at the most recent far subtree that can still hold a closer node.
+        do {
+            if (stack_size == 0) {
+                return this->WriteNeighbors(heap, heap_size, out_neighbors, out_radius2);
             }
-        }
-        curr_idx = kd_nodes[curr_idx]->parent;
+            stack_size--;
+        } while (stack[stack_size].plane_distance2 >= radius2);
+        node_index = stack[stack_size].index;
     }
+}
 
-    // Fill out vector with actual data nodes based on indicies in "nodes" vector.
-    for (int idx : node_indicies) {
-        out_neighbors.push_back(data_nodes[idx]);
-    }
-    return out_neighbors.size();
+template <typename NodeData>
+unsigned int KdTree<NodeData>::Size() const
+{
+    return nodes.size();
 }
 
+template <typename NodeData>
+const NodeData& KdTree<NodeData>::At(unsigned int index) const
+{
+    return nodes[index];
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <la.h>
+
+//A spatial index over any type with a glm::vec3 position that finds the nodes nearest to a point.
+//The photon maps use it so that the structure behind them can be swapped.
+template <typename NodeData>
+class NeighborLookup
+{
+public:
+    //The most neighbors a single LookUp can return.
+    static const int MAX_NEIGHBORS = 256;
+
+    virtual ~NeighborLookup() {}
+
+    //Finds the neighbor_num nodes closest to position that are less than max_dist away from it, and
+    //writes pointers to them to out_neighbors, which must hold neighbor_num entries. The neighbors are not
+    //sorted by distance. out_radius2, if given, is set to the squared distance of the farthest one.
+    //Returns how many were found. neighbor_num is clamped to MAX_NEIGHBORS, and nothing is allocated.
+    virtual int LookUp(const glm::vec3& position,
+            int neighbor_num,
+            float max_dist,
+            const NodeData** out_neighbors,
+            float* out_radius2 = NULL) const = 0;
+
+    //The nodes in the index, in no particular order.
+    virtual unsigned int Size() const = 0;
+    virtual const NodeData& At(unsigned int index) const = 0;
+
+protected:
+    struct Neighbor
+    {
+        float distance2;
+        unsigned int index;
+    };
+
+    // Adds a candidate to a max-heap of at most capacity neighbors, keyed on distance.
+    static void PushNeighbor(Neighbor* heap, int& heap_size, int capacity, const Neighbor& candidate);
+
+    // Writes the heap's nodes to a LookUp's outputs and returns how many there are.
+    int WriteNeighbors(const Neighbor* heap, int heap_size, const NodeData** out_neighbors, float* out_radius2) const;
+};
+
+template <typename NodeData>
+void NeighborLookup<NodeData>::PushNeighbor(Neighbor* heap, int& heap_size, int capacity, const Neighbor& candidate)
+{
+    int i;
+    if (heap_size < capacity) {
+        // Sift the new neighbor up from the end.
+        i = heap_size++;
+        while (i > 0 && heap[(i - 1) / 2].distance2 < candidate.distance2) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+    } else {
+        // Replace the farthest neighbor and sift the new one down.
+        i = 0;
+        while (true) {
+            int child = 2 * i + 1;
+            if (child >= heap_size) {
+                break;
+            }
+            if (child + 1 < heap_size && heap[child + 1].distance2 > heap[child].distance2) {
+                child++;
+            }
+            if (heap[child].distance2 <= candidate.distance2) {
+                break;
+            }
+            heap[i] = heap[child];
+            i = child;
+        }
+    }
+    heap[i] = candidate;
+}
+
+template <typename NodeData>
+int NeighborLookup<NodeData>::WriteNeighbors(const Neighbor* heap, int heap_size, const NodeData** out_neighbors, float* out_radius2) const
+{
+    for (int i = 0; i < heap_size; i++) {
+        out_neighbors[i] = &At(heap[i].index);
+    }
+    if (out_radius2 != NULL) {
+        *out_radius2 = heap_size > 0 ? heap[0].distance2 : 0.f;
+    }
+    return heap_size;
+}
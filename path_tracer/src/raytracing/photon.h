@@ -27,6 +27,7 @@ public:
         position = ph.position;
         wi = ph.wi;
         color = ph.color;
+        return *this;
     }
 
     glm::vec3 position;
@@ -0,0 +1,105 @@
+#include <raytracing/photonhashgrid.h>
+
+PhotonHashGrid::PhotonHashGrid() :
+    bucket_mask(0), cell_size(1.f), inverse_cell_size(1.f)
+{}
+
+PhotonHashGrid::PhotonHashGrid(const std::vector<Photon> &data, float max_dist) :
+    photons(data.size())
+{
+    cell_size = glm::max(2.f * max_dist, 1e-3f);
+    inverse_cell_size = 1.f / cell_size;
+
+    // About one bucket per photon keeps the buckets short without leaving most of them empty.
+    unsigned int bucket_count = 1;
+    while (bucket_count < data.size()) {
+        bucket_count *= 2;
+    }
+    bucket_mask = bucket_count - 1;
+
+    // Counting sort the photons by bucket.
+    std::vector<unsigned int> photon_buckets(data.size());
+    bucket_starts.assign(bucket_count + 1, 0);
+    for (unsigned int i = 0; i < data.size(); i++) {
+        glm::vec3 cell = glm::floor(data[i].position * inverse_cell_size);
+        photon_buckets[i] = Bucket(int(cell.x), int(cell.y), int(cell.z));
+        bucket_starts[photon_buckets[i] + 1]++;
+    }
+    for (unsigned int b = 0; b < bucket_count; b++) {
+        bucket_starts[b + 1] += bucket_starts[b];
+    }
+    std::vector<unsigned int> next_slot(bucket_starts.begin(), bucket_starts.end() - 1);
+    for (unsigned int i = 0; i < data.size(); i++) {
+        photons[next_slot[photon_buckets[i]]++] = data[i];
+    }
+}
+
+unsigned int PhotonHashGrid::Bucket(int x, int y, int z) const
+{
+    return ((unsigned int)x * 73856093u ^ (unsigned int)y * 19349663u ^ (unsigned int)z * 83492791u) & bucket_mask;
+}
+
+int PhotonHashGrid::LookUp(
+        const glm::vec3& position,
+        int neighbor_num,
+        float max_dist,
+        const Photon** out_neighbors,
+        float* out_radius2
+        ) const
+{
+    neighbor_num = glm::min(neighbor_num, int(MAX_NEIGHBORS));
+    if (photons.empty() || neighbor_num <= 0)
+    {
+        return 0;
+    }
+
+    Neighbor heap[MAX_NEIGHBORS];
+    int heap_size = 0;
+    // Any further and the search would need more than the two cells per axis scanned below.
+    float radius = glm::min(max_dist, 0.5f * cell_size);
+    float radius2 = radius * radius;
+
+    glm::vec3 low_cell = glm::floor((position - radius) * inverse_cell_size);
+    // Rounding can only push the far corner one cell too far when the search is exactly a cell wide.
+    glm::vec3 high_cell = glm::min(glm::floor((position + radius) * inverse_cell_size), low_cell + 1.f);
+    // Two of the cells may hash to the same bucket, which must only be scanned once.
+    unsigned int scanned_buckets[8];
+    int scanned_count = 0;
+    for (int z = int(low_cell.z); z <= int(high_cell.z); z++) {
+        for (int y = int(low_cell.y); y <= int(high_cell.y); y++) {
+            for (int x = int(low_cell.x); x <= int(high_cell.x); x++) {
+                unsigned int bucket = Bucket(x, y, z);
+                bool scanned = false;
+                for (int i = 0; i < scanned_count; i++) {
+                    scanned = scanned || scanned_buckets[i] == bucket;
+                }
+                if (scanned) {
+                    continue;
+                }
+                scanned_buckets[scanned_count++] = bucket;
+
+                for (unsigned int i = bucket_starts[bucket]; i < bucket_starts[bucket + 1]; i++) {
+                    float distance2 = glm::distance2(photons[i].position, position);
+                    if (distance2 < radius2) {
+                        Neighbor candidate = { distance2, i };
+                        PushNeighbor(heap, heap_size, neighbor_num, candidate);
+                        if (heap_size == neighbor_num) {
+                            radius2 = heap[0].distance2;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return WriteNeighbors(heap, heap_size, out_neighbors, out_radius2);
+}
+
+unsigned int PhotonHashGrid::Size() const
+{
+    return photons.size();
+}
+
+const Photon& PhotonHashGrid::At(unsigned int index) const
+{
+    return photons[index];
+}
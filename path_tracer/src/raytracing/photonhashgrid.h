@@ -0,0 +1,37 @@
+#pragma once
+
+#include <la.h>
+#include <vector>
+#include <raytracing/photon.h>
+#include <raytracing/neighborlookup.h>
+
+//Photons bucketed by the grid cell they lie in, with the cells hashed into a table (Teschner et al.,
+//"Optimized Spatial Hashing for Collision Detection of Deformable Objects"). Each bucket's photons are
+//stored next to each other, so a fixed-radius query is a scan of at most 8 short runs of the array
+//rather than a walk down a tree. Cells that hash to the same bucket share it.
+class PhotonHashGrid : public NeighborLookup<Photon>
+{
+public:
+    PhotonHashGrid();
+    //Cells are twice max_dist wide, so that a search of radius max_dist covers at most two cells along
+    //each axis. LookUp searches no further than max_dist.
+    PhotonHashGrid(const std::vector<Photon> &data, float max_dist);
+
+    virtual int LookUp(const glm::vec3& position,
+            int neighbor_num,
+            float max_dist,
+            const Photon** out_neighbors,
+            float* out_radius2 = NULL) const;
+
+    virtual unsigned int Size() const;
+    virtual const Photon& At(unsigned int index) const;
+
+private:
+    unsigned int Bucket(int x, int y, int z) const;
+
+    std::vector<Photon> photons;                //Sorted by bucket.
+    std::vector<unsigned int> bucket_starts;    //Bucket b holds photons [bucket_starts[b], bucket_starts[b + 1]).
+    unsigned int bucket_mask;                   //The bucket count is a power of two, and this is one less.
+    float cell_size;
+    float inverse_cell_size;
+};
@@ -1,11 +1,16 @@
 #include "photonmapintegrator.h"
+#include <QThread>
+#include <thread>
+#include <iostream>
+#include <chrono>
 
 PhotonMapIntegrator::PhotonMapIntegrator() :
     indirect_photons_requested(0),
     caustic_photons_requested(0),
     volumetric_photons_requested(0),
-    mersenne_generator(0),
-    unif_distribution(0,1)
+    photon_paths(2000),
+    photon_seed(0),
+    lookup_type(PHOTON_LOOKUP_KD_TREE)
 
 {
     scene = NULL;
@@ -16,9 +21,6 @@ PhotonMapIntegrator::PhotonMapIntegrator() :
     nearest_neighbors_num = 10;
     max_dist_from_neighbors = 10.f;
     volumetric_photons_requested = 0;
-
-    indirect_map = NULL;
-    caustic_map = NULL;
 }
 
 PhotonMapIntegrator::PhotonMapIntegrator(Scene* scene,
@@ -27,22 +29,15 @@ PhotonMapIntegrator::PhotonMapIntegrator(Scene* scene,
         , int volumetric_photons_requested) :
     indirect_photons_requested(indirect_photons_requested),
     caustic_photons_requested(caustic_photons_requested),
-    mersenne_generator(0),
-    unif_distribution(0,1)
+    volumetric_photons_requested(volumetric_photons_requested),
+    photon_paths(2000),
+    photon_seed(0),
+    lookup_type(PHOTON_LOOKUP_KD_TREE)
 {
-    scene = scene;
+    this->scene = scene;
     intersection_engine = NULL;
     nearest_neighbors_num = 10;
     max_dist_from_neighbors = 10.f;
-
-    indirect_map = NULL;
-    caustic_map = NULL;
-
-}
-
-PhotonMapIntegrator::~PhotonMapIntegrator()
-{
-
 }
 
 void PhotonMapIntegrator::SetIndirectPhotonsNum(const int& num)
@@ -65,41 +60,113 @@ void PhotonMapIntegrator::SetMaxDistanceFromNeighbors(const float& max_dist)
     max_dist_from_neighbors = max_dist;
 }
 
+void PhotonMapIntegrator::SetPhotonPathsNum(const int& num)
+{
+    photon_paths = num;
+}
+
+void PhotonMapIntegrator::SetPhotonSeed(const unsigned int& seed)
+{
+    photon_seed = seed;
+}
+
+void PhotonMapIntegrator::SetPhotonLookup(PhotonLookupType type)
+{
+    lookup_type = type;
+}
+
+NeighborLookup<Photon>* PhotonMapIntegrator::CreatePhotonMap(const std::vector<Photon> &photons) const
+{
+    if (lookup_type == PHOTON_LOOKUP_HASH_GRID) {
+        return new PhotonHashGrid(photons, max_dist_from_neighbors);
+    }
+    return new KdTree<Photon>(photons);
+}
+
 void PhotonMapIntegrator::PrePass()
 {
-    if (scene->lights.isEmpty()) {
+    if (scene->lights.isEmpty() || photon_paths <= 0) {
         return;
     }
 
     //
-    // -- Declare variables for photon shooting
+    // -- Split the photon paths between threads
     //
 
-    int paths_num = 2000;
-    std::vector<Photon> direct_photons;
+    // Every thread traces a contiguous run of paths into buffers of its own, and may keep its share of
+    // each map's photons. Merging the buffers in thread order makes the maps the same on every run with
+    // the same seed and thread count. Quota a thread leaves unused is not passed on to the others, so the
+    // maps can hold fewer photons than requested; the summary below reports both counts.
+    int thread_count = scene->render_options.thread_count > 0 ? scene->render_options.thread_count
+                                                              : glm::max(QThread::idealThreadCount(), 1);
+    thread_count = glm::max(glm::min(thread_count, photon_paths), 1);
+    std::vector<PhotonBuffers> buffers(thread_count);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_count; ++i)
+    {
+        int first_path = int((long long)photon_paths * i / thread_count);
+        int end_path = int((long long)photon_paths * (i + 1) / thread_count);
+        buffers[i].indirect_limit = int((long long)indirect_photons_requested * end_path / photon_paths)
+                                  - int((long long)indirect_photons_requested * first_path / photon_paths);
+        buffers[i].caustic_limit = int((long long)caustic_photons_requested * end_path / photon_paths)
+                                 - int((long long)caustic_photons_requested * first_path / photon_paths);
+        threads.push_back(std::thread(&PhotonMapIntegrator::TracePhotonPaths, this, first_path, end_path, &buffers[i]));
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
     std::vector<Photon> indirect_photons;
     std::vector<Photon> caustic_photons;
+    indirect_photons.reserve(indirect_photons_requested);
+    caustic_photons.reserve(caustic_photons_requested);
+    for (const PhotonBuffers &buffer : buffers)
+    {
+        indirect_photons.insert(indirect_photons.end(), buffer.indirect.begin(), buffer.indirect.end());
+        caustic_photons.insert(caustic_photons.end(), buffer.caustic.begin(), buffer.caustic.end());
+    }
+
     //
-    // -- Compute light power CDF for photon shooting
+    // -- Store photons into kd-tree maps
     //
 
+    indirect_map.reset(CreatePhotonMap(indirect_photons));
+    caustic_map.reset(CreatePhotonMap(caustic_photons));
+
+    std::cout << "Traced " << photon_paths << " photon paths on " << thread_count << " threads, stored "
+              << indirect_photons.size() << " of " << indirect_photons_requested << " requested indirect and "
+              << caustic_photons.size() << " of " << caustic_photons_requested << " requested caustic photons" << std::endl;
+
     //
-    // -- Shoot photons!
+    // -- (Possibly) construct radiance map for final gathering
     //
+}
 
-    // Choose a light to shoot photon from
-    Geometry* light = scene->lights[rand() % scene->lights.size()];
+void PhotonMapIntegrator::TracePhotonPaths(int first_path, int end_path, PhotonBuffers *buffers)
+{
+    IndependentSampler photon_sampler(1);
 
-    for (int i = 0; i < paths_num; ++i)
+    for (int i = first_path; i < end_path; ++i)
     {
         // -- RESET
         unsigned int bounce_count = 0;
         bool specular_path = true;
 
         // -- DIRECT LIGHTING
+        // Every path draws from its own sequence, so the maps are the same on every pass and do not
+        // depend on which thread traced the path.
+        photon_sampler.StartPixelSample(glm::ivec2(photon_seed, 0), i);
+
+        // Choose a light to shoot photon from
+        // Each path picks its own light in proportion to its power, and divides by the chance of picking it.
+        float light_choice_pdf;
+        Geometry* light = scene->lights[scene->light_distribution.Sample(photon_sampler.Get1D(), &light_choice_pdf)];
+
         // Sample light
-        float r1 = unif_distribution(mersenne_generator);
-        float r2 = unif_distribution(mersenne_generator);
+        glm::vec2 light_sample = photon_sampler.Get2D();
+        float r1 = light_sample.x;
+        float r2 = light_sample.y;
 
         // Sample from light
         glm::vec3 ray_direction;
@@ -116,10 +183,10 @@ void PhotonMapIntegrator::PrePass()
         isx_light.t = 0;
 
         // Factor based on angle.
-        glm::vec3 photon_energy =  light->material->EvaluateScatteredEnergy(isx_light, glm::vec3(), ray_direction);
+        glm::vec3 photon_energy =  light->material->EvaluateScatteredEnergy(isx_light, glm::vec3(), ray_direction, photon_sampler);
 
         // LTE term for this iteration;
-        glm::vec3 alpha = photon_energy;
+        glm::vec3 alpha = photon_energy / light_choice_pdf;
 
         while(true) {
 
@@ -136,23 +203,23 @@ void PhotonMapIntegrator::PrePass()
 
             if (bounce_count == 0)
             {
-                direct_photons.push_back(Photon(bounced_isx.point, ray.direction, alpha));
+                // Direct lighting is computed at render time, so the first hit is not stored.
             }
 
             // Bounce is specular
             else if (bounced_isx.object_hit->material->IsSpecular() &&
                      specular_path &&
-                     caustic_photons.size() < caustic_photons_requested
+                     buffers->caustic.size() < buffers->caustic_limit
                      )
             {
-                caustic_photons.push_back(Photon(bounced_isx.point, ray.direction, alpha));
+                buffers->caustic.push_back(Photon(bounced_isx.point, ray.direction, alpha));
             }
 
             // Bounce is diffuse
-            else if (indirect_photons.size() < indirect_photons_requested)
+            else if (buffers->indirect.size() < buffers->indirect_limit)
             {
                 specular_path = false;
-                indirect_photons.push_back(Photon(bounced_isx.point, ray.direction, alpha));
+                buffers->indirect.push_back(Photon(bounced_isx.point, ray.direction, alpha));
             }
             else
             {
@@ -167,7 +234,8 @@ void PhotonMapIntegrator::PrePass()
                         bounced_isx,
                         -ray.direction,
                         new_direction,
-                        new_pdf
+                        new_pdf,
+                        photon_sampler
                         );
 
             float cosine_component = glm::abs(glm::dot(new_direction, bounced_isx.normal));
@@ -184,7 +252,7 @@ void PhotonMapIntegrator::PrePass()
 
             // Use Russian roulette to terminate
             float continue_probability = 0.5f;//glm::min(1.f, new_alpha.y / alpha.y);
-            if (unif_distribution(mersenne_generator) > continue_probability && bounce_count > 3 || bounce_count > 5) {
+            if (photon_sampler.Get1D() > continue_probability && bounce_count > 3 || bounce_count > 5) {
                break;
             }
 
@@ -197,20 +265,9 @@ void PhotonMapIntegrator::PrePass()
             bounce_count++;
         }
     }
-
-    //
-    // -- Store photons into kd-tree maps
-    //
-
-    indirect_map = new KdTree<Photon>(indirect_photons);
-    caustic_map = new KdTree<Photon>(caustic_photons);
-
-    //
-    // -- (Possibly) construct radiance map for final gathering
-    //
 }
 
-glm::vec3 PhotonMapIntegrator::TraceRay(Ray r, unsigned int depth, int pixel_i, int pixel_j)
+glm::vec3 PhotonMapIntegrator::TraceRay(Ray r, unsigned int depth, Sampler &sampler, AOVSample *aovs)
 {
     glm::vec3 color = glm::vec3(0.0f);
     // If recursion depth max hit, return black.
@@ -219,7 +276,7 @@ glm::vec3 PhotonMapIntegrator::TraceRay(Ray r, unsigned int depth, int pixel_i,
     }
 
     Intersection isx = intersection_engine->GetIntersection(r);
-    scene->film.pixel_depths[pixel_i][pixel_j] = isx.t / pow(scene->sqrt_samples, 2);
+    RecordAOVs(isx, aovs);
     // If no object intersected or the object is in shadow, return black.
     if (!isx.object_hit) {
         return color;
@@ -228,41 +285,45 @@ glm::vec3 PhotonMapIntegrator::TraceRay(Ray r, unsigned int depth, int pixel_i,
     // If we hit a light, just return the color of the light * energy.
     if (isx.object_hit->material->is_light_source) {
         return isx.object_hit->material->base_color
-                *isx.object_hit->material->EvaluateScatteredEnergy(isx, glm::vec3(0), -r.direction);
+                *isx.object_hit->material->EvaluateScatteredEnergy(isx, glm::vec3(0), -r.direction, sampler);
     }
 
     glm::vec3 bounced_direction, energy_back;
     float pdf;
-    glm::vec3 direct_light = ComputeDirectLighting(r, isx, pdf, bounced_direction, energy_back);
+    glm::vec3 direct_light = ComputeDirectLighting(r, isx, pdf, bounced_direction, energy_back, sampler);
 
 //    color += direct_light;
 
     // Boune once
     // Bounce on bxdf surfaces
-    isx.object_hit->material->SampleAndEvaluateScatteredEnergy(isx, -r.direction, bounced_direction, pdf);
+    isx.object_hit->material->SampleAndEvaluateScatteredEnergy(isx, -r.direction, bounced_direction, pdf, sampler);
     Ray bounced_ray(isx.point + bounced_direction * OFFSET, bounced_direction);
     Intersection bounced_isx = intersection_engine->GetIntersection(bounced_ray);
     if (bounced_isx.object_hit == NULL || bounced_isx.object_hit->material->is_light_source) {
        return color;
     }
 
-    std::vector<Photon> neighbors;
+    const Photon* neighbors[NeighborLookup<Photon>::MAX_NEIGHBORS];
+    int neighbors_found;
     if (bounced_isx.object_hit->material->IsSpecular())
     {
-        caustic_map->LookUp(bounced_isx.point, nearest_neighbors_num, max_dist_from_neighbors, neighbors);
+        neighbors_found = caustic_map->LookUp(bounced_isx.point, nearest_neighbors_num, max_dist_from_neighbors, neighbors);
     }
     else
     {
-        indirect_map->LookUp(bounced_isx.point, nearest_neighbors_num, max_dist_from_neighbors, neighbors);
+        neighbors_found = indirect_map->LookUp(bounced_isx.point, nearest_neighbors_num, max_dist_from_neighbors, neighbors);
     }
 
     // Average neighbors' colors
     glm::vec3 average_neighbors_color;
-    for (Photon neighbor_photon: neighbors)
+    for (int i = 0; i < neighbors_found; i++)
     {
-        average_neighbors_color += neighbor_photon.color;
+        average_neighbors_color += neighbors[i]->color;
+    }
+    if (neighbors_found > 0)
+    {
+        average_neighbors_color /= float(neighbors_found);
     }
-    average_neighbors_color /= neighbors.size();
 
     color += average_neighbors_color;
 
@@ -270,3 +331,55 @@ glm::vec3 PhotonMapIntegrator::TraceRay(Ray r, unsigned int depth, int pixel_i,
 }
 
 
+
+void PhotonMapIntegrator::BenchmarkLookups(int query_count) const
+{
+    if (!indirect_map || indirect_map->Size() == 0 || query_count <= 0)
+    {
+        std::cout << "There are no indirect photons to look up" << std::endl;
+        return;
+    }
+
+    std::vector<Photon> photons;
+    photons.reserve(indirect_map->Size());
+    for (unsigned int i = 0; i < indirect_map->Size(); i++)
+    {
+        photons.push_back(indirect_map->At(i));
+    }
+
+    // Photons lie on the surfaces that get shaded, so queries at photons look like the render's queries.
+    PCG32 rng;
+    std::vector<glm::vec3> queries(query_count);
+    for (glm::vec3 &query : queries)
+    {
+        query = photons[rng.NextUInt(photons.size())].position;
+    }
+
+    const char* names[2] = {"kd-tree", "hash grid"};
+    for (int type = 0; type < 2; type++)
+    {
+        std::chrono::steady_clock::time_point build_start = std::chrono::steady_clock::now();
+        NeighborLookup<Photon>* map;
+        if (type == 0) {
+            map = new KdTree<Photon>(photons);
+        } else {
+            map = new PhotonHashGrid(photons, max_dist_from_neighbors);
+        }
+        std::chrono::steady_clock::time_point query_start = std::chrono::steady_clock::now();
+
+        const Photon* neighbors[NeighborLookup<Photon>::MAX_NEIGHBORS];
+        long long neighbors_found = 0;
+        for (const glm::vec3 &query : queries)
+        {
+            neighbors_found += map->LookUp(query, nearest_neighbors_num, max_dist_from_neighbors, neighbors);
+        }
+        std::chrono::steady_clock::time_point query_end = std::chrono::steady_clock::now();
+        delete map;
+
+        std::chrono::duration<double> build_seconds = query_start - build_start;
+        std::chrono::duration<double> query_seconds = query_end - query_start;
+        std::cout << names[type] << ": built over " << photons.size() << " photons in " << build_seconds.count()
+                  << " s, " << query_count / glm::max(query_seconds.count(), 1e-9) << " queries per second, "
+                  << double(neighbors_found) / query_count << " neighbors per query" << std::endl;
+    }
+}
@@ -3,34 +3,65 @@
 #include <raytracing/directlightingintegrator.h>
 #include <raytracing/photon.h>
 #include <raytracing/kdtree.h>
+#include <raytracing/photonhashgrid.h>
+#include <raytracing/samplers/independentsampler.h>
+#include <memory>
+
+//The structures a photon map can be stored in. See CreatePhotonMap.
+enum PhotonLookupType {
+    PHOTON_LOOKUP_KD_TREE,      //Finds the nearest photons at any distance.
+    PHOTON_LOOKUP_HASH_GRID     //Faster, but only searches as far as maxDistance.
+};
+
+//The photons one PrePass thread stores, and how many of each kind it may keep.
+struct PhotonBuffers
+{
+    std::vector<Photon> indirect;
+    std::vector<Photon> caustic;
+    unsigned int indirect_limit;
+    unsigned int caustic_limit;
+};
 
 class PhotonMapIntegrator : public DirectLightingIntegrator
 {
 public:
     PhotonMapIntegrator();
     PhotonMapIntegrator(Scene* scene, int indirect_photons_requested, int caustic_photons_requested, int volumetric_photons_requested);
-    ~PhotonMapIntegrator();
     virtual void PrePass();
-    virtual glm::vec3 TraceRay(Ray r, unsigned int depth, int pixel_i, int pixel_j);
+    virtual glm::vec3 TraceRay(Ray r, unsigned int depth, Sampler &sampler, AOVSample *aovs = NULL);
 
     virtual void SetIndirectPhotonsNum(const int& num);
     virtual void SetCausticPhotonsNum(const int& num);
     virtual void SetNearestNeighborsNum(const int& num);
     virtual void SetMaxDistanceFromNeighbors(const float& max_dist);
+    virtual void SetPhotonPathsNum(const int& num);
+    virtual void SetPhotonSeed(const unsigned int& seed);
+    virtual void SetPhotonLookup(PhotonLookupType type);
+
+    //Times query_count lookups in a kd-tree and a hash grid built from the indirect photons, and prints
+    //how many each answers per second. Call after PrePass.
+    void BenchmarkLookups(int query_count) const;
 
 protected:
+    //Traces the photon paths with indices in [first_path, end_path) and stores their photons in buffers.
+    //Runs on one of PrePass's threads.
+    void TracePhotonPaths(int first_path, int end_path, PhotonBuffers *buffers);
+    //Stores photons in the structure chosen by lookup_type. The caller owns it.
+    NeighborLookup<Photon>* CreatePhotonMap(const std::vector<Photon> &photons) const;
 
-    KdTree<Photon>* indirect_map;
-    KdTree<Photon>* caustic_map;
-    KdTree<Photon>* volumetric_map;
+    //The integrator owns its maps, so it can be moved, e.g. when a scene file's settings are loaded
+    //over it, but not copied.
+    std::unique_ptr<NeighborLookup<Photon> > indirect_map;
+    std::unique_ptr<NeighborLookup<Photon> > caustic_map;
+    std::unique_ptr<NeighborLookup<Photon> > volumetric_map;
 
     int indirect_photons_requested;
     int caustic_photons_requested;
     int volumetric_photons_requested;
     int nearest_neighbors_num;
     float max_dist_from_neighbors;
-
-    std::mt19937 mersenne_generator;
-    std::uniform_real_distribution<float> unif_distribution;
+    int photon_paths;//Paths traced from the lights in PrePass.
+    unsigned int photon_seed;//Picks the random sequences the photon paths draw from.
+    PhotonLookupType lookup_type;
 };
 
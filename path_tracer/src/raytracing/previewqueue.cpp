@@ -0,0 +1,36 @@
+#include <raytracing/previewqueue.h>
+
+PreviewTile::PreviewTile(const RenderTile &tile) :
+    tile(tile), colors((tile.x_end - tile.x_start) * (tile.y_end - tile.y_start)), next(NULL)
+{}
+
+PreviewQueue::PreviewQueue() : head(NULL)
+{}
+
+PreviewQueue::~PreviewQueue()
+{
+    Clear();
+}
+
+void PreviewQueue::Push(PreviewTile *tile)
+{
+    // Release publishes the tile's colors to whichever thread takes it.
+    tile->next = head.load(std::memory_order_relaxed);
+    while (!head.compare_exchange_weak(tile->next, tile, std::memory_order_release, std::memory_order_relaxed))
+    {}
+}
+
+PreviewTile *PreviewQueue::TakeAll()
+{
+    return head.exchange(NULL, std::memory_order_acquire);
+}
+
+void PreviewQueue::Clear()
+{
+    PreviewTile *tile = TakeAll();
+    while (tile != NULL) {
+        PreviewTile *next = tile->next;
+        delete tile;
+        tile = next;
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <raytracing/tilescheduler.h>
+#include <la.h>
+#include <atomic>
+#include <vector>
+
+//The colors of one finished tile, clamped to [0, 1] and stored row by row.
+struct PreviewTile {
+    PreviewTile(const RenderTile &tile);
+
+    RenderTile tile;
+    std::vector<glm::vec3> colors;
+    PreviewTile *next;
+};
+
+//A lock-free stack that render threads push finished tiles onto and the GUI thread empties in
+//one exchange. Since the only pop takes the whole stack at once, there is no ABA problem.
+class PreviewQueue
+{
+public:
+    PreviewQueue();
+    ~PreviewQueue();
+
+    //Takes ownership of the tile. Safe to call from any number of threads at once.
+    void Push(PreviewTile *tile);
+    //Removes every tile pushed so far and returns them as a list linked through next, newest
+    //first. The caller owns the tiles.
+    PreviewTile *TakeAll();
+    //Deletes every tile still in the queue.
+    void Clear();
+
+private:
+    std::atomic<PreviewTile*> head;
+};
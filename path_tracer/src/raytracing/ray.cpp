@@ -1,9 +1,12 @@
 #include <raytracing/ray.h>
+#include <limits>
 
 Ray::Ray(const glm::vec3 &o, const glm::vec3 &d):
     origin(o),
     direction(glm::normalize(d)),
-    transmitted_color(1,1,1)
+    transmitted_color(1,1,1),
+    t_min(0),
+    t_max(std::numeric_limits<float>::infinity())
 {}
 
 Ray::Ray(const glm::vec4 &o, const glm::vec4 &d):
@@ -14,12 +17,16 @@ Ray::Ray(const Ray &r):
     Ray(r.origin, r.direction)
 {
     transmitted_color = r.transmitted_color;
+    t_min = r.t_min;
+    t_max = r.t_max;
 }
 
 Ray::Ray():
     origin(0),
     direction(0),
-    transmitted_color(1,1,1)
+    transmitted_color(1,1,1),
+    t_min(0),
+    t_max(std::numeric_limits<float>::infinity())
 {}
 
 Ray Ray::GetTransformedCopy(const glm::mat4 &T) const
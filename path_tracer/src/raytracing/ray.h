@@ -16,4 +16,6 @@ public:
     glm::vec3 origin;
     glm::vec3 direction;
     glm::vec3 transmitted_color;
+    float t_min;    //Hits closer than this along the ray are ignored, e.g. in front of the near clip plane
+    float t_max;    //Hits at or beyond this are ignored. Secondary rays leave the range unbounded.
 };
@@ -0,0 +1,51 @@
+#pragma once
+
+//The orders in which a render's tiles are handed out.
+enum TileOrder {
+    TILE_ORDER_SCANLINE,    //Row by row, starting at the top left.
+    TILE_ORDER_HILBERT,     //Along a Hilbert curve, so consecutive tiles are neighbours.
+    TILE_ORDER_CENTER_OUT   //By distance from the center of the image.
+};
+
+//The sample generators a render can draw its random numbers from. See CreateSampler.
+enum SamplerType {
+    SAMPLER_INDEPENDENT,    //Uncorrelated PCG32 values.
+    SAMPLER_SOBOL,          //Owen-scrambled (0,2)-sequence points, shuffled independently per dimension.
+    SAMPLER_HALTON          //Halton points, rotated per pixel.
+};
+
+//The reconstruction filters the film can weight samples with. See CreateFilter.
+enum FilterType {
+    FILTER_BOX,
+    FILTER_TENT,
+    FILTER_GAUSSIAN,
+    FILTER_MITCHELL
+};
+
+//Settings that control how a render is split across threads, sampled and reconstructed. These are read from the scene file's <render> tag.
+struct RenderOptions {
+    RenderOptions():
+    tile_size(16), tile_order(TILE_ORDER_HILBERT), thread_count(0), sampler_type(SAMPLER_SOBOL),
+    filter_type(FILTER_BOX), filter_radius(0.5f),
+    samples_per_pass(0), max_samples(0), time_limit(0.0f), noise_threshold(0.0f),
+    adaptive_threshold(0.0f), adaptive_min_samples(16) {}
+
+    int tile_size;          //Width and height of a tile in pixels.
+    TileOrder tile_order;
+    int thread_count;       //Render threads to start. 0 starts one per core.
+    SamplerType sampler_type;
+    FilterType filter_type;
+    float filter_radius;    //In pixels. A box of radius 0.5 averages the samples inside each pixel.
+
+    //A render runs in passes that each add samples_per_pass samples to every pixel, and stops after the
+    //first pass that meets any of the limits below.
+    int samples_per_pass;   //0 takes every sample in a single pass.
+    int max_samples;        //Samples per pixel. 0 uses the scene's pixelSampleLength squared.
+    float time_limit;       //Seconds since the render started. Checked between passes. 0 means no limit.
+    float noise_threshold;  //Mean relative error of the pixels, see Film::EstimateNoise. 0 means no limit.
+
+    //Between passes, pixels whose relative error is below adaptive_threshold stop taking samples, so
+    //later passes only go to the noisy parts of the image. The render stops once every pixel has.
+    float adaptive_threshold;   //0 gives every pixel the same samples.
+    int adaptive_min_samples;   //Samples a pixel takes before its error estimate is trusted.
+};
@@ -0,0 +1,75 @@
+#include <raytracing/samplers/aliastable.h>
+#include <la.h>
+
+AliasTable::AliasTable()
+{}
+
+void AliasTable::Build(const std::vector<float> &weights)
+{
+    int count = weights.size();
+    columns.assign(count, Column());
+    if (count == 0) {
+        return;
+    }
+
+    double total = 0.0;
+    for (float w : weights) {
+        total += w;
+    }
+
+    // Scale the weights so that a column holds exactly 1, then sort them into the columns they underfill
+    // and the columns they overfill.
+    std::vector<double> scaled(count);
+    std::vector<int> under, over;
+    for (int i = 0; i < count; i++) {
+        columns[i].pdf = total > 0.0 ? float(weights[i] / total) : 1.f / count;
+        scaled[i] = total > 0.0 ? weights[i] / total * count : 1.0;
+        (scaled[i] < 1.0 ? under : over).push_back(i);
+    }
+
+    // Top up every underfilled column from an overfilled index, which becomes that column's alias.
+    while (!under.empty() && !over.empty()) {
+        int underfilled = under.back();
+        under.pop_back();
+        int overfilled = over.back();
+        columns[underfilled].threshold = float(scaled[underfilled]);
+        columns[underfilled].alias = overfilled;
+        scaled[overfilled] -= 1.0 - scaled[underfilled];
+        if (scaled[overfilled] < 1.0) {
+            over.pop_back();
+            under.push_back(overfilled);
+        }
+    }
+    // What is left is 1 up to rounding error.
+    for (int i : over) {
+        columns[i].threshold = 1.f;
+        columns[i].alias = i;
+    }
+    for (int i : under) {
+        columns[i].threshold = 1.f;
+        columns[i].alias = i;
+    }
+}
+
+int AliasTable::Sample(float u, float *pdf) const
+{
+    int count = columns.size();
+    float scaled = u * count;
+    int column = glm::min(int(scaled), count - 1);
+    // The part of u inside the column is uniform too, so it chooses between the column and its alias.
+    int index = (scaled - column) < columns[column].threshold ? column : columns[column].alias;
+    if (pdf != NULL) {
+        *pdf = columns[index].pdf;
+    }
+    return index;
+}
+
+float AliasTable::Pdf(int index) const
+{
+    return columns[index].pdf;
+}
+
+int AliasTable::Size() const
+{
+    return columns.size();
+}
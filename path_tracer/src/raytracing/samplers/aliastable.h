@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+//Picks an index with probability proportional to its weight in constant time, using Walker's alias
+//method (Vose, "A Linear Algorithm for Generating Random Numbers with a Given Distribution"). Every
+//index owns a column of equal size, which it shares with at most one other index, its alias.
+class AliasTable
+{
+public:
+    AliasTable();
+
+    //Weights must not be negative. If they are all zero, every index is equally likely.
+    void Build(const std::vector<float> &weights);
+
+    //Maps a uniform u in [0, 1) to an index, and sets pdf to the chance of picking it if pdf is given.
+    int Sample(float u, float *pdf = NULL) const;
+    float Pdf(int index) const;
+    int Size() const;
+
+private:
+    struct Column
+    {
+        float threshold;    //The chance that a u landing in this column picks the column's own index.
+        int alias;          //The index picked otherwise.
+        float pdf;          //The chance of picking the column's own index from the whole table.
+    };
+    std::vector<Column> columns;
+};
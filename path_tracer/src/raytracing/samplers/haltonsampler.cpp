@@ -0,0 +1,39 @@
+#include <raytracing/samplers/haltonsampler.h>
+#include <raytracing/samplers/lowdiscrepancy.h>
+
+static const uint32_t PRIMES[HALTON_MAX_DIMENSION] = {
+    2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53,
+    59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131,
+    137, 139, 149, 151, 157, 163, 167, 173, 179, 181, 191, 193, 197, 199, 211, 223,
+    227, 229, 233, 239, 241, 251, 257, 263, 269, 271, 277, 281, 283, 293, 307, 311
+};
+
+HaltonSampler::HaltonSampler(int samples_per_pixel) :
+    Sampler(samples_per_pixel), pixel(0), sample_index(0), dimension(0)
+{}
+
+void HaltonSampler::StartPixelSample(const glm::ivec2 &pixel, int sample_index)
+{
+    this->pixel = pixel;
+    this->sample_index = sample_index;
+    dimension = 0;
+    fallback_rng.SeedPixelSample(pixel.x, pixel.y, sample_index);
+}
+
+float HaltonSampler::Get1D()
+{
+    if (dimension >= HALTON_MAX_DIMENSION) {
+        return fallback_rng.NextFloat();
+    }
+    uint64_t pixel_bits = ((uint64_t)(uint32_t)pixel.x << 32) | (uint32_t)pixel.y;
+    float offset = FixedPointToFloat((uint32_t)PCG32::MixBits(PCG32::MixBits(pixel_bits) ^ dimension));
+    float value = RadicalInverse(PRIMES[dimension++], sample_index) + offset;
+    value = value >= 1.0f ? value - 1.0f : value;
+    return value < ONE_MINUS_EPSILON ? value : ONE_MINUS_EPSILON;
+}
+
+glm::vec2 HaltonSampler::Get2D()
+{
+    float x = Get1D();
+    return glm::vec2(x, Get1D());
+}
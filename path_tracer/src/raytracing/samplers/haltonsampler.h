@@ -0,0 +1,25 @@
+#pragma once
+#include <raytracing/samplers/sampler.h>
+#include <raytracing/samplers/pcg32.h>
+
+//Dimensions covered by the Halton sequence. A path that asks for more falls back to independent values.
+#define HALTON_MAX_DIMENSION 64
+
+//Gives dimension d of sample i the radical inverse of i in the d-th prime base. Every pixel shifts each
+//dimension by its own random offset (a Cranley-Patterson rotation) so neighbouring pixels don't share
+//the same points.
+class HaltonSampler : public Sampler
+{
+public:
+    HaltonSampler(int samples_per_pixel);
+
+    virtual void StartPixelSample(const glm::ivec2 &pixel, int sample_index);
+    virtual float Get1D();
+    virtual glm::vec2 Get2D();
+
+protected:
+    glm::ivec2 pixel;
+    int sample_index;
+    int dimension;
+    PCG32 fallback_rng; //Used past HALTON_MAX_DIMENSION.
+};
@@ -0,0 +1,20 @@
+#include <raytracing/samplers/independentsampler.h>
+
+IndependentSampler::IndependentSampler(int samples_per_pixel) : Sampler(samples_per_pixel)
+{}
+
+void IndependentSampler::StartPixelSample(const glm::ivec2 &pixel, int sample_index)
+{
+    rng.SeedPixelSample(pixel.x, pixel.y, sample_index);
+}
+
+float IndependentSampler::Get1D()
+{
+    return rng.NextFloat();
+}
+
+glm::vec2 IndependentSampler::Get2D()
+{
+    float x = rng.NextFloat();
+    return glm::vec2(x, rng.NextFloat());
+}
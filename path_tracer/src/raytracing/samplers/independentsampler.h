@@ -0,0 +1,18 @@
+#pragma once
+#include <raytracing/samplers/sampler.h>
+#include <raytracing/samplers/pcg32.h>
+
+//Draws every dimension from a PCG32 seeded for the pixel and sample, so the values are uncorrelated
+//but reproducible.
+class IndependentSampler : public Sampler
+{
+public:
+    IndependentSampler(int samples_per_pixel);
+
+    virtual void StartPixelSample(const glm::ivec2 &pixel, int sample_index);
+    virtual float Get1D();
+    virtual glm::vec2 Get2D();
+
+protected:
+    PCG32 rng;
+};
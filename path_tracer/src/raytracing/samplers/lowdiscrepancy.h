@@ -0,0 +1,107 @@
+#pragma once
+#include <cstdint>
+
+//Building blocks shared by the quasi-Monte Carlo samplers.
+
+//The largest float below 1. Sample values are clamped to it so that they stay in [0, 1).
+const float ONE_MINUS_EPSILON = 0.99999994f;
+
+inline uint32_t ReverseBits32(uint32_t v)
+{
+    v = (v << 16) | (v >> 16);
+    v = ((v & 0x00ff00ff) << 8) | ((v & 0xff00ff00) >> 8);
+    v = ((v & 0x0f0f0f0f) << 4) | ((v & 0xf0f0f0f0) >> 4);
+    v = ((v & 0x33333333) << 2) | ((v & 0xcccccccc) >> 2);
+    v = ((v & 0x55555555) << 1) | ((v & 0xaaaaaaaa) >> 1);
+    return v;
+}
+
+//The first two dimensions of the Sobol sequence as 32-bit fixed point fractions. Together they form
+//a (0,2)-sequence: every power-of-two run of points starting at a multiple of its length is
+//stratified over every elementary interval of the unit square.
+inline uint32_t Sobol32Dimension0(uint32_t index)
+{
+    return ReverseBits32(index);
+}
+
+inline uint32_t Sobol32Dimension1(uint32_t index)
+{
+    uint32_t result = 0;
+    for (uint32_t v = 1u << 31; index != 0; index >>= 1, v ^= v >> 1) {
+        if (index & 1) {
+            result ^= v;
+        }
+    }
+    return result;
+}
+
+//Randomizes a fixed point fraction with a hash based approximation of Owen's nested uniform scrambling
+//(Burley, "Practical Hash-based Owen Scrambling"). Each seed gives a different scramble, and
+//scrambling keeps the stratification of the (0,2)-sequence.
+inline uint32_t OwenScramble(uint32_t v, uint32_t seed)
+{
+    v = ReverseBits32(v);
+    v ^= v * 0x3d20adea;
+    v += seed;
+    v *= (seed >> 16) | 1;
+    v ^= v * 0x05526c56;
+    v ^= v * 0x53a22864;
+    return ReverseBits32(v);
+}
+
+inline float FixedPointToFloat(uint32_t v)
+{
+    float result = v * 2.3283064365386963e-10f;  // 2^-32
+    return result < ONE_MINUS_EPSILON ? result : ONE_MINUS_EPSILON;
+}
+
+//Returns element i of a pseudo-random permutation of [0, length) chosen by seed
+//(Kensler, "Correlated Multi-Jittered Sampling").
+inline uint32_t PermutationElement(uint32_t i, uint32_t length, uint32_t seed)
+{
+    uint32_t w = length - 1;
+    w |= w >> 1;
+    w |= w >> 2;
+    w |= w >> 4;
+    w |= w >> 8;
+    w |= w >> 16;
+    // Cycle-walk until the hashed value lands inside the permutation's range.
+    do {
+        i ^= seed;
+        i *= 0xe170893d;
+        i ^= seed >> 16;
+        i ^= (i & w) >> 4;
+        i ^= seed >> 8;
+        i *= 0x0929eb3f;
+        i ^= seed >> 23;
+        i ^= (i & w) >> 1;
+        i *= 1 | seed >> 27;
+        i *= 0x6935fa69;
+        i ^= (i & w) >> 11;
+        i *= 0x74dcb303;
+        i ^= (i & w) >> 2;
+        i *= 0x9e501cc3;
+        i ^= (i & w) >> 2;
+        i *= 0xc860a3df;
+        i &= w;
+        i ^= i >> 5;
+    } while (i >= length);
+    return (i + seed) % length;
+}
+
+//Reverses the base-b digits of index about the radix point.
+inline float RadicalInverse(uint32_t base, uint64_t index)
+{
+    float inv_base = 1.0f / base;
+    float inv_base_power = 1.0f;
+    uint64_t reversed_digits = 0;
+    while (index != 0) {
+        uint64_t next = index / base;
+        uint64_t digit = index - next * base;
+        reversed_digits = reversed_digits * base + digit;
+        inv_base_power *= inv_base;
+        index = next;
+    }
+    float result = reversed_digits * inv_base_power;
+    return result < ONE_MINUS_EPSILON ? result : ONE_MINUS_EPSILON;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+
+//A PCG32 random number generator (O'Neill, "PCG: A Family of Simple Fast Space-Efficient Statistically
+//Good Algorithms for Random Number Generation"). Its whole state is two 64-bit integers, so every render
+//thread can own one and draw from it without the lock that rand() takes. Seeding it from the pixel and
+//sample index makes every sample's random numbers independent of which thread renders it.
+class PCG32
+{
+public:
+    PCG32() { Seed(0x853c49e6748fea9bULL, 0xda3e39cb94b95bdbULL); }
+    PCG32(uint64_t initial_state, uint64_t sequence) { Seed(initial_state, sequence); }
+
+    //Starts the generator at initial_state in one of 2^63 independent sequences.
+    void Seed(uint64_t initial_state, uint64_t sequence)
+    {
+        state = 0u;
+        increment = (sequence << 1u) | 1u;
+        NextUInt();
+        state += initial_state;
+        NextUInt();
+    }
+
+    //Seeds the generator for one sample of one pixel. Nearby pixels are scrambled so that their
+    //sequences are not offsets of one another, and every sample index gets its own sequence.
+    void SeedPixelSample(uint32_t x, uint32_t y, uint32_t sample_index)
+    {
+        Seed(MixBits(((uint64_t)x << 32) | y), MixBits(sample_index));
+    }
+
+    uint32_t NextUInt()
+    {
+        uint64_t old_state = state;
+        state = old_state * 6364136223846793005ULL + increment;
+        uint32_t xorshifted = (uint32_t)(((old_state >> 18u) ^ old_state) >> 27u);
+        uint32_t rotation = (uint32_t)(old_state >> 59u);
+        return (xorshifted >> rotation) | (xorshifted << ((~rotation + 1u) & 31));
+    }
+
+    //Returns a uniformly distributed integer in [0, bound) without modulo bias.
+    uint32_t NextUInt(uint32_t bound)
+    {
+        uint32_t threshold = (~bound + 1u) % bound;
+        while (true) {
+            uint32_t r = NextUInt();
+            if (r >= threshold) {
+                return r % bound;
+            }
+        }
+    }
+
+    //Returns a uniformly distributed float in [0, 1).
+    float NextFloat()
+    {
+        // The top 24 bits fill a float's mantissa exactly, so the result never rounds up to 1.
+        return (NextUInt() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    //The 64-bit finalizer of SplitMix64.
+    static uint64_t MixBits(uint64_t v)
+    {
+        v = (v ^ (v >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        v = (v ^ (v >> 27)) * 0x94d049bb133111ebULL;
+        return v ^ (v >> 31);
+    }
+
+private:
+    uint64_t state;
+    uint64_t increment;
+};
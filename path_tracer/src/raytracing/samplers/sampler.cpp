@@ -0,0 +1,29 @@
+#include <raytracing/samplers/sampler.h>
+#include <raytracing/samplers/independentsampler.h>
+#include <raytracing/samplers/sobolsampler.h>
+#include <raytracing/samplers/haltonsampler.h>
+
+Sampler::Sampler(int samples_per_pixel) : samples_per_pixel(glm::max(samples_per_pixel, 1))
+{}
+
+int Sampler::GetIndex(int count)
+{
+    return glm::min(int(Get1D() * count), count - 1);
+}
+
+int Sampler::SamplesPerPixel() const
+{
+    return samples_per_pixel;
+}
+
+Sampler* CreateSampler(SamplerType type, int samples_per_pixel)
+{
+    switch (type) {
+    case SAMPLER_SOBOL:
+        return new SobolSampler(samples_per_pixel);
+    case SAMPLER_HALTON:
+        return new HaltonSampler(samples_per_pixel);
+    default:
+        return new IndependentSampler(samples_per_pixel);
+    }
+}
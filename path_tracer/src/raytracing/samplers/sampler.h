@@ -0,0 +1,32 @@
+#pragma once
+#include <la.h>
+#include <raytracing/renderoptions.h>
+
+//Supplies the random numbers for one path sample at a time. A path asks for its values in a fixed order
+//(pixel position, lens position, then light and BxDF choices at every bounce), and each request is the
+//next dimension of the sample. Quasi-Monte Carlo samplers spread a pixel's samples evenly over every
+//dimension, which takes fewer samples to reach a given noise level than independent random numbers.
+//A sampler is not thread safe; every render thread makes its own.
+class Sampler
+{
+public:
+    Sampler(int samples_per_pixel);
+    virtual ~Sampler(){}
+
+    //Restarts the dimensions at the first one for sample sample_index of the pixel.
+    virtual void StartPixelSample(const glm::ivec2 &pixel, int sample_index) = 0;
+    //Returns the next dimension of the current sample, in [0, 1).
+    virtual float Get1D() = 0;
+    //Returns the next two dimensions of the current sample, in [0, 1)^2.
+    virtual glm::vec2 Get2D() = 0;
+    //Uses the next dimension to pick an integer in [0, count).
+    int GetIndex(int count);
+
+    int SamplesPerPixel() const;
+
+protected:
+    int samples_per_pixel;  //Samples in [0, samples_per_pixel) are spread evenly over each dimension.
+};
+
+//Makes a sampler of the given type. The caller owns it.
+Sampler* CreateSampler(SamplerType type, int samples_per_pixel);
@@ -0,0 +1,38 @@
+#include <raytracing/samplers/sobolsampler.h>
+#include <raytracing/samplers/lowdiscrepancy.h>
+#include <raytracing/samplers/pcg32.h>
+
+SobolSampler::SobolSampler(int samples_per_pixel) :
+    Sampler(samples_per_pixel), pixel(0), sample_index(0), dimension(0)
+{}
+
+void SobolSampler::StartPixelSample(const glm::ivec2 &pixel, int sample_index)
+{
+    this->pixel = pixel;
+    this->sample_index = sample_index;
+    dimension = 0;
+}
+
+uint64_t SobolSampler::NextDimensionHash()
+{
+    uint64_t pixel_bits = ((uint64_t)(uint32_t)pixel.x << 32) | (uint32_t)pixel.y;
+    return PCG32::MixBits(PCG32::MixBits(pixel_bits) ^ dimension++);
+}
+
+float SobolSampler::Get1D()
+{
+    uint64_t hash = NextDimensionHash();
+    uint32_t index = PermutationElement(sample_index, samples_per_pixel, (uint32_t)hash);
+    return FixedPointToFloat(OwenScramble(Sobol32Dimension0(index), (uint32_t)(hash >> 32)));
+}
+
+glm::vec2 SobolSampler::Get2D()
+{
+    uint64_t hash = NextDimensionHash();
+    uint32_t index = PermutationElement(sample_index, samples_per_pixel, (uint32_t)hash);
+    // Each axis needs its own scramble, so the second seed is rehashed from the first.
+    uint32_t seed_x = (uint32_t)(hash >> 32);
+    uint32_t seed_y = (uint32_t)PCG32::MixBits(hash);
+    return glm::vec2(FixedPointToFloat(OwenScramble(Sobol32Dimension0(index), seed_x)),
+                     FixedPointToFloat(OwenScramble(Sobol32Dimension1(index), seed_y)));
+}
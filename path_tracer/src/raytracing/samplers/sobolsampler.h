@@ -0,0 +1,24 @@
+#pragma once
+#include <raytracing/samplers/sampler.h>
+
+//Takes every 1D and 2D request from the first dimensions of the Sobol sequence, which form a
+//(0,2)-sequence. The pixel's sample index is shuffled by a different permutation for each request so
+//that successive dimensions are not correlated, and the points are Owen scrambled per pixel and
+//dimension. Stratification is best when the sample count is a power of two.
+class SobolSampler : public Sampler
+{
+public:
+    SobolSampler(int samples_per_pixel);
+
+    virtual void StartPixelSample(const glm::ivec2 &pixel, int sample_index);
+    virtual float Get1D();
+    virtual glm::vec2 Get2D();
+
+protected:
+    //Hashes the pixel and current dimension, then moves on to the next dimension.
+    uint64_t NextDimensionHash();
+
+    glm::ivec2 pixel;
+    int sample_index;
+    uint32_t dimension;
+};
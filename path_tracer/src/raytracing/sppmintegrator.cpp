@@ -0,0 +1,384 @@
+#include <raytracing/sppmintegrator.h>
+#include <raytracing/samplers/independentsampler.h>
+#include <QThread>
+#include <thread>
+#include <functional>
+#include <chrono>
+#include <climits>
+#include <iostream>
+
+SPPMIntegrator::SPPMIntegrator() :
+    photons_per_iteration(100000),
+    initial_radius(1.f),
+    alpha(2.f / 3.f),
+    thread_count(1),
+    grid_mask(0),
+    grid_cell_size(1.f)
+{
+    scene = NULL;
+    intersection_engine = NULL;
+}
+
+void SPPMIntegrator::SetPhotonsPerIteration(const int& num)
+{
+    photons_per_iteration = num;
+}
+
+void SPPMIntegrator::SetInitialRadius(const float& radius)
+{
+    initial_radius = radius;
+}
+
+//Runs task(i) for every i in [0, count) on a thread of its own, and waits for them all to finish.
+static void RunOnThreads(unsigned int count, const std::function<void(unsigned int)> &task)
+{
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        threads.push_back(std::thread(task, i));
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+//Visible points are only stored, and photons only gathered, where the surface scatters light diffusely
+//or glossily; a perfect mirror or glass surface passes both on instead.
+static bool HasNonSpecularBxDF(const Material *material)
+{
+    for (BxDF *bxdf : material->bxdfs)
+    {
+        if (!(bxdf->type & BSDF_SPECULAR)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SPPMIntegrator::Render()
+{
+    Film &film = scene->film;
+    const RenderOptions &options = scene->render_options;
+    thread_count = options.thread_count > 0 ? options.thread_count : glm::max(QThread::idealThreadCount(), 1);
+    int max_iterations = options.max_samples > 0 ? options.max_samples
+                                                 : (options.time_limit > 0.f ? INT_MAX : scene->sqrt_samples * scene->sqrt_samples);
+
+    film.Clear();
+    pixels.assign(film.width * film.height, SPPMPixel());
+    for (SPPMPixel &pixel : pixels)
+    {
+        pixel.radius = initial_radius;
+    }
+    if (scene->lights.isEmpty() || photons_per_iteration <= 0)
+    {
+        std::cout << "SPPM needs a light and at least one photon per iteration" << std::endl;
+        return;
+    }
+
+    // The buffers are the only memory an iteration needs besides the pixels, and they are reused.
+    std::vector<SPPMPhotonBuffers> buffers(thread_count);
+    for (SPPMPhotonBuffers &buffer : buffers)
+    {
+        buffer.flux.resize(pixels.size());
+        buffer.photons_gathered.resize(pixels.size());
+    }
+
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    for (int iteration = 0; iteration < max_iterations; iteration++)
+    {
+        //
+        // -- Camera pass: find this iteration's visible points
+        //
+
+        RunOnThreads(thread_count, [this, &film, iteration](unsigned int i) {
+            TraceVisiblePoints(film.height * i / thread_count, film.height * (i + 1) / thread_count, iteration);
+        });
+        BuildVisiblePointGrid();
+
+        //
+        // -- Photon pass: every thread gathers its share of the photons into buffers of its own
+        //
+
+        RunOnThreads(thread_count, [this, &buffers, iteration](unsigned int i) {
+            int first_photon = int((long long)photons_per_iteration * i / thread_count);
+            int end_photon = int((long long)photons_per_iteration * (i + 1) / thread_count);
+            TracePhotons(iteration, first_photon, end_photon, &buffers[i]);
+        });
+        UpdatePixels(buffers, iteration + 1);
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+        std::cout << "Iteration " << iteration + 1 << ": " << (long long)photons_per_iteration * (iteration + 1)
+                  << " photons, " << elapsed.count() << " s" << std::endl;
+        if (options.time_limit > 0.f && elapsed.count() >= options.time_limit)
+        {
+            std::cout << "Stopping at the time limit of " << options.time_limit << " s" << std::endl;
+            break;
+        }
+    }
+}
+
+void SPPMIntegrator::TraceVisiblePoints(unsigned int y_start, unsigned int y_end, int iteration)
+{
+    IndependentSampler sampler(1);
+    Film &film = scene->film;
+    for (unsigned int y = y_start; y < y_end; y++)
+    {
+        for (unsigned int x = 0; x < film.width; x++)
+        {
+            SPPMPixel &pixel = pixels[y * film.width + x];
+            pixel.has_visible_point = false;
+
+            sampler.StartPixelSample(glm::ivec2(x, y), iteration);
+            glm::vec2 film_sample = glm::vec2(x, y) + sampler.Get2D();
+            glm::vec2 lens_sample = sampler.Get2D();
+            Ray ray = scene->camera.Raycast(film_sample, lens_sample);
+            glm::vec3 beta(1.f);
+
+            for (unsigned int depth = 0; depth <= max_depth; depth++)
+            {
+                Intersection isx = intersection_engine->GetIntersection(ray);
+                if (depth == 0)
+                {
+                    AOVSample aovs;
+                    RecordAOVs(isx, &aovs);
+                    film.AddPixelAOVs(x, y, aovs);
+                }
+                if (isx.object_hit == NULL)
+                {
+                    break;
+                }
+
+                Material *material = isx.object_hit->material;
+                if (material->is_light_source)
+                {
+                    // Lights look the same as they do with the other integrators.
+                    pixel.direct += beta * material->base_color * material->EvaluateScatteredEnergy(isx, glm::vec3(0), -ray.direction, sampler);
+                    break;
+                }
+                if (HasNonSpecularBxDF(material))
+                {
+                    float pdf;
+                    glm::vec3 new_direction, energy_back;
+                    pixel.direct += beta * ComputeDirectLighting(ray, isx, pdf, new_direction, energy_back, sampler);
+                    pixel.has_visible_point = true;
+                    pixel.visible_point = isx;
+                    pixel.wo = -ray.direction;
+                    pixel.beta = beta;
+                    break;
+                }
+
+                // Follow the ray through mirrors and glass.
+                glm::vec3 wi;
+                float pdf;
+                glm::vec3 energy = material->SampleAndEvaluateScatteredEnergy(isx, -ray.direction, wi, pdf, sampler);
+                if (fequal(pdf, 0.f) || (fequal(energy.x, 0.f) && fequal(energy.y, 0.f) && fequal(energy.z, 0.f)))
+                {
+                    break;
+                }
+                beta *= energy * glm::abs(glm::dot(wi, isx.normal)) / pdf;
+                ray = Ray(isx.point + wi * OFFSET, wi);
+            }
+        }
+    }
+}
+
+unsigned int SPPMIntegrator::Bucket(int x, int y, int z) const
+{
+    return ((unsigned int)x * 73856093u ^ (unsigned int)y * 19349663u ^ (unsigned int)z * 83492791u) & grid_mask;
+}
+
+void SPPMIntegrator::BuildVisiblePointGrid()
+{
+    // Cells twice as wide as the largest radius put every gather sphere in at most two cells per axis.
+    float max_radius = 0.f;
+    unsigned int point_count = 0;
+    for (const SPPMPixel &pixel : pixels)
+    {
+        if (pixel.has_visible_point) {
+            max_radius = glm::max(max_radius, pixel.radius);
+            point_count++;
+        }
+    }
+    grid_cell_size = glm::max(2.f * max_radius, 1e-3f);
+    unsigned int bucket_count = 1;
+    while (bucket_count < point_count) {
+        bucket_count *= 2;
+    }
+    grid_mask = bucket_count - 1;
+
+    // Lists the distinct buckets of the cells a pixel's gather sphere overlaps.
+    unsigned int pixel_buckets[8];
+    auto overlapped_buckets = [this, &pixel_buckets](const SPPMPixel &pixel) {
+        glm::vec3 low_cell = glm::floor((pixel.visible_point.point - pixel.radius) / grid_cell_size);
+        glm::vec3 high_cell = glm::min(glm::floor((pixel.visible_point.point + pixel.radius) / grid_cell_size), low_cell + 1.f);
+        int count = 0;
+        for (int z = int(low_cell.z); z <= int(high_cell.z); z++) {
+            for (int y = int(low_cell.y); y <= int(high_cell.y); y++) {
+                for (int x = int(low_cell.x); x <= int(high_cell.x); x++) {
+                    unsigned int bucket = Bucket(x, y, z);
+                    bool listed = false;
+                    for (int i = 0; i < count; i++) {
+                        listed = listed || pixel_buckets[i] == bucket;
+                    }
+                    if (!listed) {
+                        pixel_buckets[count++] = bucket;
+                    }
+                }
+            }
+        }
+        return count;
+    };
+
+    // Counting sort the pixels into the buckets.
+    grid_starts.assign(bucket_count + 1, 0);
+    for (const SPPMPixel &pixel : pixels)
+    {
+        if (pixel.has_visible_point) {
+            int count = overlapped_buckets(pixel);
+            for (int i = 0; i < count; i++) {
+                grid_starts[pixel_buckets[i] + 1]++;
+            }
+        }
+    }
+    for (unsigned int b = 0; b < bucket_count; b++)
+    {
+        grid_starts[b + 1] += grid_starts[b];
+    }
+    grid_pixels.resize(grid_starts[bucket_count]);
+    std::vector<unsigned int> next_slot(grid_starts.begin(), grid_starts.end() - 1);
+    for (unsigned int p = 0; p < pixels.size(); p++)
+    {
+        if (pixels[p].has_visible_point) {
+            int count = overlapped_buckets(pixels[p]);
+            for (int i = 0; i < count; i++) {
+                grid_pixels[next_slot[pixel_buckets[i]]++] = p;
+            }
+        }
+    }
+}
+
+void SPPMIntegrator::TracePhotons(int iteration, int first_photon, int end_photon, SPPMPhotonBuffers *buffers)
+{
+    std::fill(buffers->flux.begin(), buffers->flux.end(), glm::vec3(0.f));
+    std::fill(buffers->photons_gathered.begin(), buffers->photons_gathered.end(), 0);
+    IndependentSampler sampler(1);
+
+    for (int i = first_photon; i < end_photon; i++)
+    {
+        // Every photon draws from its own sequence, so the image does not depend on the thread count.
+        // No pixel has a negative row, so these never repeat a camera ray's sequence.
+        sampler.StartPixelSample(glm::ivec2(iteration, -1), i);
+
+        float light_choice_pdf;
+        Geometry *light = scene->lights[scene->light_distribution.Sample(sampler.Get1D(), &light_choice_pdf)];
+        glm::vec2 area_sample = sampler.Get2D();
+        glm::vec2 direction_sample = sampler.Get2D();
+        glm::vec3 origin = light->SampleArea(area_sample.x, area_sample.y, glm::vec3(), true);
+        glm::vec3 direction = light->SamplePhotonDirectionFromLight(direction_sample.x, direction_sample.y, true);
+
+        // ComputeNormal works in the light's object space, and the emission test needs the world normal.
+        glm::vec3 local_origin(light->transform.invT() * glm::vec4(origin, 1.f));
+        Intersection light_isx;
+        light_isx.point = origin;
+        light_isx.normal = glm::normalize(glm::vec3(light->transform.invTransT() * glm::vec4(light->ComputeNormal(local_origin), 0.f)));
+        light_isx.object_hit = light;
+        light_isx.t = 0;
+
+        // The point is uniform over the light's area and the direction is cosine weighted, so the flux
+        // is the emitted radiance times pi times the area, over the chance of picking this light.
+        glm::vec3 beta = light->material->EvaluateScatteredEnergy(light_isx, glm::vec3(), direction, sampler)
+                * (PI * light->area / light_choice_pdf);
+        if (fequal(beta.x, 0.f) && fequal(beta.y, 0.f) && fequal(beta.z, 0.f))
+        {
+            continue;
+        }
+
+        Ray ray(origin + direction * OFFSET, direction);
+        for (unsigned int depth = 0; depth <= max_depth; depth++)
+        {
+            Intersection isx = intersection_engine->GetIntersection(ray);
+            if (isx.object_hit == NULL || isx.object_hit->material->is_light_source)
+            {
+                break;
+            }
+            Material *material = isx.object_hit->material;
+
+            // Light arriving straight from a light source is the camera pass's direct lighting.
+            if (depth > 0 && HasNonSpecularBxDF(material))
+            {
+                GatherPhoton(Photon(isx.point, ray.direction, beta), sampler, buffers);
+            }
+
+            glm::vec3 wi;
+            float pdf;
+            glm::vec3 energy = material->SampleAndEvaluateScatteredEnergy(isx, -ray.direction, wi, pdf, sampler);
+            if (fequal(pdf, 0.f) || (fequal(energy.x, 0.f) && fequal(energy.y, 0.f) && fequal(energy.z, 0.f)))
+            {
+                break;
+            }
+            glm::vec3 new_beta = beta * energy * glm::abs(glm::dot(wi, isx.normal)) / pdf;
+
+            // Russian roulette on the power lost at this bounce, so the photons that survive keep
+            // roughly the power they started with.
+            float continue_probability = glm::min(1.f, fmax(fmax(new_beta.x, new_beta.y), new_beta.z)
+                                                     / fmax(fmax(beta.x, beta.y), beta.z));
+            if (sampler.Get1D() >= continue_probability)
+            {
+                break;
+            }
+            beta = new_beta / continue_probability;
+            ray = Ray(isx.point + wi * OFFSET, wi);
+        }
+    }
+}
+
+void SPPMIntegrator::GatherPhoton(const Photon &photon, Sampler &sampler, SPPMPhotonBuffers *buffers)
+{
+    glm::vec3 cell = glm::floor(photon.position / grid_cell_size);
+    unsigned int bucket = Bucket(int(cell.x), int(cell.y), int(cell.z));
+    for (unsigned int i = grid_starts[bucket]; i < grid_starts[bucket + 1]; i++)
+    {
+        unsigned int p = grid_pixels[i];
+        const SPPMPixel &pixel = pixels[p];
+        if (glm::distance2(pixel.visible_point.point, photon.position) >= pixel.radius * pixel.radius) {
+            continue;
+        }
+        // As in the photon maps, photon.wi is the direction the photon was travelling in.
+        glm::vec3 energy = pixel.visible_point.object_hit->material->EvaluateScatteredEnergy(
+                    pixel.visible_point, pixel.wo, -photon.wi, sampler);
+        buffers->flux[p] += pixel.beta * energy * photon.color;
+        buffers->photons_gathered[p]++;
+    }
+}
+
+void SPPMIntegrator::UpdatePixels(const std::vector<SPPMPhotonBuffers> &buffers, int iterations_done)
+{
+    Film &film = scene->film;
+    double photons_traced = (double)photons_per_iteration * iterations_done;
+    for (unsigned int p = 0; p < pixels.size(); p++)
+    {
+        SPPMPixel &pixel = pixels[p];
+        glm::vec3 flux(0.f);
+        int photons_gathered = 0;
+        for (const SPPMPhotonBuffers &buffer : buffers)
+        {
+            flux += buffer.flux[p];
+            photons_gathered += buffer.photons_gathered[p];
+        }
+
+        // Keep only alpha of the new photons, and shrink the radius so that the photon density inside
+        // it is what it would have been with all of them.
+        if (photons_gathered > 0)
+        {
+            float new_count = pixel.photon_count + alpha * photons_gathered;
+            float new_radius = pixel.radius * glm::sqrt(new_count / (pixel.photon_count + photons_gathered));
+            pixel.tau = (pixel.tau + flux) * (new_radius * new_radius) / (pixel.radius * pixel.radius);
+            pixel.photon_count = new_count;
+            pixel.radius = new_radius;
+        }
+
+        glm::vec3 indirect = pixel.tau / float(photons_traced * PI * pixel.radius * pixel.radius);
+        film.SetPixel(p % film.width, p / film.width, pixel.direct / float(iterations_done) + indirect);
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <raytracing/directlightingintegrator.h>
+#include <raytracing/photon.h>
+#include <vector>
+
+//What stochastic progressive photon mapping knows about one pixel.
+struct SPPMPixel
+{
+    SPPMPixel() :
+        radius(0.f), direct(0.f), tau(0.f), photon_count(0.f), has_visible_point(false) {}
+
+    float radius;           //Photons closer than this to the visible point add to its flux.
+    glm::vec3 direct;       //Emitted and direct light summed over every iteration.
+    glm::vec3 tau;          //Flux gathered within radius, rescaled every time radius shrinks.
+    float photon_count;     //The photons tau has been gathered from so far.
+
+    //The first diffuse surface this iteration's camera ray reached, and the ray's throughput up to it.
+    bool has_visible_point;
+    Intersection visible_point;
+    glm::vec3 wo;
+    glm::vec3 beta;
+};
+
+//The flux that photons of one iteration add to each pixel's visible point, for one thread.
+struct SPPMPhotonBuffers
+{
+    std::vector<glm::vec3> flux;
+    std::vector<int> photons_gathered;
+};
+
+//Stochastic progressive photon mapping (Hachisuka and Jensen, "Stochastic Progressive Photon Mapping").
+//Every iteration traces one camera ray per pixel to a visible point, then traces a batch of photons and
+//adds each one to the visible points it lands near. Between iterations every pixel's gather radius
+//shrinks, so the image converges to the right answer while memory stays fixed: photons are never
+//stored, and only the per-pixel statistics are kept.
+//It needs per-pixel state across iterations, so it renders the film itself instead of going through
+//Renderer and TraceRay.
+class SPPMIntegrator : public DirectLightingIntegrator
+{
+public:
+    SPPMIntegrator();
+
+    //Runs iterations until the scene's max samples (one per pixel per iteration) or time limit is
+    //reached, and writes the estimate to the scene's film after each one. Without either limit it runs
+    //pixelSampleLength squared iterations.
+    void Render();
+
+    virtual void SetPhotonsPerIteration(const int& num);
+    virtual void SetInitialRadius(const float& radius);
+
+protected:
+    //Traces camera rays through specular surfaces for the pixel rows [y_start, y_end), adding the light
+    //they see to each pixel and storing where they land.
+    void TraceVisiblePoints(unsigned int y_start, unsigned int y_end, int iteration);
+    //Buckets every visible point into each grid cell its gather radius overlaps.
+    void BuildVisiblePointGrid();
+    //Traces the photons with indices in [first_photon, end_photon) of an iteration and gathers them into buffers.
+    void TracePhotons(int iteration, int first_photon, int end_photon, SPPMPhotonBuffers *buffers);
+    //Adds a photon to every visible point it lies within the radius of.
+    void GatherPhoton(const Photon &photon, Sampler &sampler, SPPMPhotonBuffers *buffers);
+    //Shrinks the gather radii with the iteration's photons and writes the new estimate to the film.
+    void UpdatePixels(const std::vector<SPPMPhotonBuffers> &buffers, int iterations_done);
+
+    unsigned int Bucket(int x, int y, int z) const;
+
+    int photons_per_iteration;
+    float initial_radius;
+    float alpha;//The fraction of an iteration's photons that count towards shrinking the radius.
+    unsigned int thread_count;
+
+    std::vector<SPPMPixel> pixels;//Row-major, the same size as the film.
+
+    //The visible points hashed by grid cell. Bucket b holds the pixels
+    //grid_pixels[grid_starts[b]] to grid_pixels[grid_starts[b + 1] - 1].
+    std::vector<unsigned int> grid_starts;
+    std::vector<unsigned int> grid_pixels;
+    unsigned int grid_mask;
+    float grid_cell_size;
+};
@@ -0,0 +1,188 @@
+#include <raytracing/tilescheduler.h>
+#include <la.h>
+#include <algorithm>
+#include <iostream>
+
+TileScheduler::TileScheduler() : tile_count(0), finished_count(0), tile_size(0)
+{}
+
+//Distance of the cell (x, y) along a Hilbert curve filling an n x n grid, n a power of two.
+static unsigned int HilbertIndex(unsigned int n, unsigned int x, unsigned int y)
+{
+    unsigned int d = 0;
+    for (unsigned int s = n / 2; s > 0; s /= 2) {
+        unsigned int rx = (x & s) > 0;
+        unsigned int ry = (y & s) > 0;
+        d += s * s * ((3 * rx) ^ ry);
+        // Rotate the quadrant so the curve inside it has the canonical orientation.
+        if (ry == 0) {
+            if (rx == 1) {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+void TileScheduler::OrderTiles(std::vector<RenderTile> &tiles, unsigned int x_count, unsigned int y_count, TileOrder order) const
+{
+    std::vector<float> keys(tiles.size());
+    if (order == TILE_ORDER_HILBERT) {
+        unsigned int n = 1;
+        while (n < x_count || n < y_count) {
+            n *= 2;
+        }
+        for (unsigned int i=0; i < tiles.size(); i++) {
+            keys[i] = HilbertIndex(n, i % x_count, i / x_count);
+        }
+    } else if (order == TILE_ORDER_CENTER_OUT) {
+        glm::vec2 center(x_count * 0.5f, y_count * 0.5f);
+        for (unsigned int i=0; i < tiles.size(); i++) {
+            glm::vec2 tile_center(i % x_count + 0.5f, i / x_count + 0.5f);
+            keys[i] = glm::length(tile_center - center);
+        }
+    } else {
+        return;
+    }
+    // Tiles are still in scanline order here, so equal keys keep that order.
+    std::stable_sort(tiles.begin(), tiles.end(), [&keys](const RenderTile &a, const RenderTile &b) {
+        return keys[a.index] < keys[b.index];
+    });
+}
+
+void TileScheduler::Reset(unsigned int width, unsigned int height, const RenderOptions &options, int worker_count,
+                          int first_sample, int sample_count)
+{
+    tile_size = glm::max(options.tile_size, 1);
+    unsigned int x_count = (width + tile_size - 1) / tile_size;
+    unsigned int y_count = (height + tile_size - 1) / tile_size;
+
+    std::vector<RenderTile> tiles;
+    for (unsigned int y=0; y < y_count; y++) {
+        for (unsigned int x=0; x < x_count; x++) {
+            RenderTile tile;
+            tile.x_start = x * tile_size;
+            tile.x_end = glm::min(tile.x_start + tile_size, width);
+            tile.y_start = y * tile_size;
+            tile.y_end = glm::min(tile.y_start + tile_size, height);
+            tile.index = tiles.size();
+            tile.first_sample = first_sample;
+            tile.sample_count = sample_count;
+            tiles.push_back(tile);
+        }
+    }
+    OrderTiles(tiles, x_count, y_count, options.tile_order);
+    tile_count = tiles.size();
+    finished_count = 0;
+
+    workers.clear();
+    for (int i=0; i < glm::max(worker_count, 1); i++) {
+        workers.push_back(std::unique_ptr<Worker>(new Worker()));
+        workers.back()->busy_seconds = 0.0;
+        workers.back()->tiles_rendered = 0;
+        workers.back()->tiles_stolen = 0;
+    }
+    // Dealing the ordered tiles round-robin keeps every worker near the front of the order.
+    for (unsigned int i=0; i < tiles.size(); i++) {
+        workers[i % workers.size()]->tiles.push_back(tiles[i]);
+    }
+    start_time = std::chrono::steady_clock::now();
+}
+
+bool TileScheduler::NextTile(int worker, RenderTile &tile)
+{
+    Worker &self = *workers[worker];
+    {
+        std::lock_guard<std::mutex> guard(self.lock);
+        if (!self.tiles.empty()) {
+            tile = self.tiles.front();
+            self.tiles.pop_front();
+            self.tiles_rendered++;
+            return true;
+        }
+    }
+    // Steal the tile the victim would have reached last.
+    for (unsigned int i=1; i < workers.size(); i++) {
+        Worker &victim = *workers[(worker + i) % workers.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tiles.empty()) {
+            tile = victim.tiles.back();
+            victim.tiles.pop_back();
+            self.tiles_rendered++;
+            self.tiles_stolen++;
+            return true;
+        }
+    }
+    // No tiles are added during a render, so every deque stays empty from here on.
+    self.finish_time = std::chrono::steady_clock::now();
+    return false;
+}
+
+void TileScheduler::FinishTile(int worker, const RenderTile &tile, double seconds)
+{
+    workers[worker]->busy_seconds += seconds;
+    {
+        std::lock_guard<std::mutex> guard(finished_lock);
+        if (++finished_count == tile_count) {
+            all_finished.notify_all();
+        }
+    }
+    // Count the tile first, so a callback that checks IsFinished after the last tile sees it done.
+    if (tile_finished) {
+        tile_finished(tile);
+    }
+}
+
+void TileScheduler::Wait()
+{
+    std::unique_lock<std::mutex> guard(finished_lock);
+    all_finished.wait(guard, [this] { return finished_count == tile_count; });
+}
+
+bool TileScheduler::IsFinished()
+{
+    std::lock_guard<std::mutex> guard(finished_lock);
+    return finished_count == tile_count;
+}
+
+void TileScheduler::SetTileFinishedCallback(const std::function<void(const RenderTile&)> &callback)
+{
+    tile_finished = callback;
+}
+
+void TileScheduler::PrintStats() const
+{
+    double wall_seconds = 0.0;
+    double total_busy = 0.0;
+    double max_busy = 0.0;
+    for (const std::unique_ptr<Worker> &worker : workers) {
+        std::chrono::duration<double> elapsed = worker->finish_time - start_time;
+        wall_seconds = glm::max(wall_seconds, elapsed.count());
+        total_busy += worker->busy_seconds;
+        max_busy = glm::max(max_busy, worker->busy_seconds);
+    }
+    std::cout << "Rendered " << tile_count << " tiles of " << tile_size << "x" << tile_size
+              << " on " << workers.size() << " threads in " << wall_seconds << " s" << std::endl;
+    for (unsigned int i=0; i < workers.size(); i++) {
+        const Worker &worker = *workers[i];
+        std::cout << "  thread " << i << ": busy " << worker.busy_seconds << " s ("
+                  << (wall_seconds > 0.0 ? 100.0 * worker.busy_seconds / wall_seconds : 0.0) << "%), "
+                  << worker.tiles_rendered << " tiles, " << worker.tiles_stolen << " stolen" << std::endl;
+    }
+    // 1 means every thread was busy for the same time.
+    double mean_busy = total_busy / workers.size();
+    std::cout << "  load imbalance (max / mean busy time): "
+              << (mean_busy > 0.0 ? max_busy / mean_busy : 1.0) << std::endl;
+}
+
+int TileScheduler::WorkerCount() const
+{
+    return workers.size();
+}
+
+int TileScheduler::TileCount() const
+{
+    return tile_count;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <raytracing/renderoptions.h>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <chrono>
+
+//A rectangle of pixels [x_start, x_end) x [y_start, y_end) rendered as one unit of work.
+struct RenderTile {
+    unsigned int x_start, x_end, y_start, y_end;
+    int index;      //Position of the tile in scanline order.
+    int first_sample, sample_count;     //The sample indices [first_sample, first_sample + sample_count) of every pixel.
+};
+
+//Splits an image into tiles and hands them out to a fixed set of workers. The tiles are put in
+//the configured order and dealt round-robin into one deque per worker. A worker takes tiles from
+//the front of its own deque and, once that runs dry, steals from the back of another worker's,
+//so no thread sits idle while tiles remain anywhere. Workers report each finished tile, which
+//counts down a latch that Wait blocks on.
+class TileScheduler
+{
+public:
+    TileScheduler();
+    //Drops any tiles left over from the last pass and deals out the tiles of a width x height image,
+    //each of which takes samples [first_sample, first_sample + sample_count) of its pixels.
+    void Reset(unsigned int width, unsigned int height, const RenderOptions &options, int worker_count,
+               int first_sample, int sample_count);
+
+    //Gets the next tile for the worker. Returns false once every tile has been handed out.
+    bool NextTile(int worker, RenderTile &tile);
+    //Called by a worker once it has written a tile, with the time it spent on it.
+    void FinishTile(int worker, const RenderTile &tile, double seconds);
+    //Sleeps until every tile of the render has been finished.
+    void Wait();
+    bool IsFinished();
+    //Called on the worker's thread each time a tile is finished, after the tile is counted. Wait can
+    //therefore return while the last callback still runs, so join the workers before the next Reset.
+    //Set it before the workers start.
+    void SetTileFinishedCallback(const std::function<void(const RenderTile&)> &callback);
+    //Prints every worker's busy time, tile count and steals to show how evenly the render was spread.
+    void PrintStats() const;
+
+    int WorkerCount() const;
+    int TileCount() const;
+
+private:
+    struct Worker {
+        std::mutex lock;                //Guards tiles. The stats are only touched by the worker itself.
+        std::deque<RenderTile> tiles;
+        double busy_seconds;
+        int tiles_rendered;
+        int tiles_stolen;
+        std::chrono::steady_clock::time_point finish_time;
+    };
+
+    void OrderTiles(std::vector<RenderTile> &tiles, unsigned int x_count, unsigned int y_count, TileOrder order) const;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    int tile_count;
+    std::mutex finished_lock;           //Guards finished_count.
+    std::condition_variable all_finished;
+    int finished_count;
+    std::function<void(const RenderTile&)> tile_finished;
+    int tile_size;
+    std::chrono::steady_clock::time_point start_time;
+};
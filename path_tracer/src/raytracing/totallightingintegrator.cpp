@@ -7,7 +7,7 @@ TotalLightingIntegrator::TotalLightingIntegrator()
 }
 
 
-glm::vec3 TotalLightingIntegrator::TraceRay(Ray r, unsigned int depth, int pixel_i, int pixel_j)
+glm::vec3 TotalLightingIntegrator::TraceRay(Ray r, unsigned int depth, Sampler &sampler, AOVSample *aovs)
 {
     glm::vec3 color = glm::vec3(0.0f);
     // If recursion depth max hit, return black.
@@ -16,7 +16,7 @@ glm::vec3 TotalLightingIntegrator::TraceRay(Ray r, unsigned int depth, int pixel
     }
 
     Intersection intersection = intersection_engine->GetIntersection(r);
-    scene->film.pixel_depths[pixel_i][pixel_j] = intersection.t / pow(scene->sqrt_samples, 2);
+    RecordAOVs(intersection, aovs);
 
     glm::vec3 offset_point = intersection.point + (intersection.normal * OFFSET);
     // If no object intersected or the object is in shadow, return black.
@@ -27,7 +27,7 @@ glm::vec3 TotalLightingIntegrator::TraceRay(Ray r, unsigned int depth, int pixel
     // If we hit a light, just return the color of the light * energy.
     if (intersection.object_hit->material->is_light_source) {
         return intersection.object_hit->material->base_color
-                *intersection.object_hit->material->EvaluateScatteredEnergy(intersection, glm::vec3(0), -r.direction);
+                *intersection.object_hit->material->EvaluateScatteredEnergy(intersection, glm::vec3(0), -r.direction, sampler);
     }
 
     // Do integrated lighting, updating the following variables.
@@ -44,7 +44,7 @@ glm::vec3 TotalLightingIntegrator::TraceRay(Ray r, unsigned int depth, int pixel
         glm::vec3 new_direction;
         float pdf;
         glm::vec3 energy;
-        glm::vec3 direct_lighting = ComputeDirectLighting(current_ray, current_intersection, pdf, new_direction, energy);
+        glm::vec3 direct_lighting = ComputeDirectLighting(current_ray, current_intersection, pdf, new_direction, energy, sampler);
         if (direct_lighting.x > 1.f) direct_lighting.x = 1.f;
         if (direct_lighting.y > 1.f) direct_lighting.y = 1.f;
         if (direct_lighting.z > 1.f) direct_lighting.z = 1.f;
@@ -100,7 +100,7 @@ glm::vec3 TotalLightingIntegrator::TraceRay(Ray r, unsigned int depth, int pixel
 
         // Terminate if russian roulette murders ray.
         if(throughput > 1.f) throughput = 1.f;
-        if ((bounces > 2) && (throughput < (float(rand()) / float(RAND_MAX)))) {
+        if ((bounces > 2) && (throughput < sampler.Get1D())) {
 //        if (bounces > 5) {
             break;
         }
@@ -0,0 +1,141 @@
+#include <renderer.h>
+#include <iostream>
+
+Renderer::Renderer()
+    : scene(NULL), integrator(NULL), preview(NULL), thread_count(1), max_samples(0), samples_taken(0), passes_done(0)
+{}
+
+Renderer::~Renderer()
+{
+    JoinThreads();
+}
+
+void Renderer::Begin(Scene *s, Integrator *i, PreviewQueue *preview_queue)
+{
+    scene = s;
+    integrator = i;
+    preview = preview_queue;
+
+    //Set up one thread per core unless the scene file asks for a specific number
+    const RenderOptions &options = scene->render_options;
+    thread_count = options.thread_count > 0 ? options.thread_count
+                                            : glm::max(QThread::idealThreadCount(), 1);
+    scene->film.SetFilter(options.filter_type, options.filter_radius);
+    scene->film.Clear();
+    max_samples = options.max_samples > 0 ? options.max_samples : scene->sqrt_samples * scene->sqrt_samples;
+    samples_taken = 0;
+    passes_done = 0;
+    start_time = std::chrono::steady_clock::now();
+}
+
+void Renderer::StartPass()
+{
+    const RenderOptions &options = scene->render_options;
+    int pass_samples = options.samples_per_pass > 0 ? options.samples_per_pass : max_samples;
+    pass_samples = glm::min(pass_samples, max_samples - samples_taken);
+    tile_scheduler.Reset(scene->camera.width, scene->camera.height, options, thread_count, samples_taken, pass_samples);
+    samples_taken += pass_samples;
+
+    //Launch the render threads; each one pulls tiles from the scheduler until none are left
+    for(unsigned int i = 0; i < thread_count; i++)
+    {
+        threads.push_back(new RenderThread(&tile_scheduler, i, max_samples, options.sampler_type, 5, &(scene->film), &(scene->camera), integrator, preview));
+        threads.back()->start();
+    }
+}
+
+void Renderer::Wait()
+{
+    tile_scheduler.Wait();
+}
+
+bool Renderer::IsPassFinished()
+{
+    return tile_scheduler.IsFinished();
+}
+
+void Renderer::JoinThreads()
+{
+    for(RenderThread *thread : threads)
+    {
+        //The last tile may finish before its thread has returned from run()
+        thread->wait();
+        delete thread;
+    }
+    threads.clear();
+}
+
+bool Renderer::FinishPass()
+{
+    JoinThreads();
+
+    const RenderOptions &options = scene->render_options;
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    float noise = scene->film.EstimateNoise();
+    std::cout << "Pass " << ++passes_done << ": " << samples_taken << " samples per pixel, "
+              << elapsed.count() << " s, noise " << noise << std::endl;
+    if(samples_taken >= max_samples)
+    {
+        return true;
+    }
+    if(options.time_limit > 0.f && elapsed.count() >= options.time_limit)
+    {
+        std::cout << "Stopping at the time limit of " << options.time_limit << " s" << std::endl;
+        return true;
+    }
+    if(options.noise_threshold > 0.f && noise <= options.noise_threshold)
+    {
+        std::cout << "Stopping at the noise threshold of " << options.noise_threshold << std::endl;
+        return true;
+    }
+    if(options.adaptive_threshold > 0.f)
+    {
+        unsigned int active = scene->film.MarkConvergedPixels(options.adaptive_threshold, options.adaptive_min_samples);
+        std::cout << "  " << active << " of " << scene->film.width * scene->film.height
+                  << " pixels still need samples" << std::endl;
+        if(active == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Renderer::Render()
+{
+    while(true)
+    {
+        StartPass();
+        //Sleep until the last tile of the pass is done instead of spinning on the threads
+        Wait();
+        if(FinishPass())
+        {
+            break;
+        }
+    }
+}
+
+void Renderer::SetTileFinishedCallback(const std::function<void(const RenderTile&)> &callback)
+{
+    tile_scheduler.SetTileFinishedCallback(callback);
+}
+
+void Renderer::PrintStats() const
+{
+    tile_scheduler.PrintStats();
+}
+
+void Renderer::WriteImages(const QString &path)
+{
+    scene->film.WriteImage(path);
+    if(scene->render_options.adaptive_threshold > 0.f)
+    {
+        //Shows where adaptive sampling spent its samples
+        QString spp_path = path;
+        if(spp_path.endsWith(QString(".bmp"), Qt::CaseInsensitive))
+        {
+            spp_path.chop(4);
+        }
+        scene->film.WriteSampleCountImage(spp_path.append(QString("_spp.bmp")).toStdString());
+    }
+}
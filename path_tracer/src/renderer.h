@@ -0,0 +1,52 @@
+#pragma once
+
+#include <renderthread.h>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+//Renders a scene's film as a series of passes. Every pass deals out the whole image again and starts
+//one RenderThread per core on it; the limits in the scene's RenderOptions decide when to stop.
+//After Begin, either call Render to block until the end, or drive the passes yourself with
+//StartPass, Wait or IsPassFinished, and FinishPass.
+//Nothing here touches OpenGL, so the GUI and the command line renderer share it.
+class Renderer
+{
+public:
+    Renderer();
+    ~Renderer();
+
+    //Clears the film and sets up a render of it. Finished tiles are pushed to preview_queue unless it is NULL.
+    void Begin(Scene* s, Integrator* i, PreviewQueue* preview_queue);
+    //Deals out the next pass's tiles and starts the render threads on them
+    void StartPass();
+    //Sleeps until every tile of the current pass is finished
+    void Wait();
+    bool IsPassFinished();
+    //Waits for the pass's threads to exit and reports the pass. Returns true if the render has reached
+    //one of its limits; otherwise stops sampling the pixels that have converged
+    bool FinishPass();
+    //Runs every pass of the render set up by Begin
+    void Render();
+
+    //Called on the render thread each time it finishes a tile. Set it before starting a pass.
+    void SetTileFinishedCallback(const std::function<void(const RenderTile&)> &callback);
+    //Prints how the last pass was spread over the threads
+    void PrintStats() const;
+    //Writes the film to path, plus a map of the samples per pixel next to it when sampling adaptively
+    void WriteImages(const QString &path);
+
+private:
+    void JoinThreads();
+
+    Scene* scene;
+    Integrator* integrator;
+    PreviewQueue* preview;
+    TileScheduler tile_scheduler;
+    std::vector<RenderThread*> threads;
+    unsigned int thread_count;
+    int max_samples;//Samples per pixel once every pass is done
+    int samples_taken;//Samples per pixel in the passes started so far
+    int passes_done;
+    std::chrono::steady_clock::time_point start_time;
+};
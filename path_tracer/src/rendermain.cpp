@@ -0,0 +1,168 @@
+#include <renderer.h>
+#include <scene/xmlreader.h>
+#include <scene/materials/volumetricmaterial.h>
+#include <raytracing/directlightingintegrator.h>
+#include <raytracing/totallightingintegrator.h>
+#include <raytracing/photonmapintegrator.h>
+#include <raytracing/sppmintegrator.h>
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFileInfo>
+#include <iostream>
+
+//The command line renderer. It loads a scene file, renders it with the same passes and render threads
+//as the GUI, and writes a BMP, all without a window or an OpenGL context:
+//    render [-i direct|total|photonMap|sppm] [-t threads] [-s samples per pixel] [-o image.bmp] scene.xml
+//With --benchmark-photons it traces the photon maps and times lookups in them instead of rendering, and
+//with --benchmark-bvh it times the mesh BVH builds at 1 to 16 threads instead of rendering.
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renders a scene file to a BMP image without a display.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("scene", "The scene XML file to render.");
+    QCommandLineOption output_option(QStringList() << "o" << "output",
+                                     "Where to write the image. Defaults to render.bmp.", "file", "render.bmp");
+    QCommandLineOption integrator_option(QStringList() << "i" << "integrator",
+                                         "direct (default), total, photonMap or sppm.", "type", "direct");
+    QCommandLineOption threads_option(QStringList() << "t" << "threads",
+                                      "Render threads, overriding the scene file. 0 starts one per core.", "count");
+    QCommandLineOption samples_option(QStringList() << "s" << "spp",
+                                      "Samples per pixel, overriding the scene file.", "count");
+    QCommandLineOption benchmark_option("benchmark-photons",
+                                        "Time this many photon lookups in a kd-tree and a hash grid instead of rendering. "
+                                        "Implies -i photonMap.", "queries");
+    QCommandLineOption bvh_benchmark_option("benchmark-bvh",
+                                            "Time every mesh BVH build at 1, 2, 4, 8 and 16 threads instead of rendering.");
+    parser.addOption(output_option);
+    parser.addOption(integrator_option);
+    parser.addOption(threads_option);
+    parser.addOption(samples_option);
+    parser.addOption(benchmark_option);
+    parser.addOption(bvh_benchmark_option);
+    parser.process(app);
+
+    const QStringList arguments = parser.positionalArguments();
+    if(arguments.size() != 1)
+    {
+        parser.showHelp(1);
+    }
+
+    //There is no OpenGL context to create the geometry's buffers in
+    Drawable::setGLEnabled(false);
+
+    QFileInfo scene_info(arguments[0]);
+    QFile file(scene_info.absoluteFilePath());
+    if(!file.exists())
+    {
+        std::cerr << "Can't find the scene file " << arguments[0].toStdString() << std::endl;
+        return 1;
+    }
+    //The reader resolves meshes and textures relative to the scene file's directory
+    QString local_path = scene_info.absolutePath().append(QString("/"));
+
+    Scene scene;
+    XMLReader xml_reader;
+    DirectLightingIntegrator direct_integrator;
+    TotalLightingIntegrator total_integrator;
+    PhotonMapIntegrator photon_map_integrator;
+    SPPMIntegrator sppm_integrator;
+    Integrator* integrator;
+    QString integrator_type = parser.value(integrator_option);
+    if(parser.isSet(benchmark_option) ||
+       QString::compare(integrator_type, QString("photonMap"), Qt::CaseInsensitive) == 0)
+    {
+        xml_reader.LoadSceneFromFilePhotonMap(file, QStringRef(&local_path), scene, photon_map_integrator);
+        integrator = &photon_map_integrator;
+    }
+    else if(QString::compare(integrator_type, QString("sppm"), Qt::CaseInsensitive) == 0)
+    {
+        xml_reader.LoadSceneFromFile(file, QStringRef(&local_path), scene, sppm_integrator);
+        integrator = &sppm_integrator;
+    }
+    else if(QString::compare(integrator_type, QString("total"), Qt::CaseInsensitive) == 0)
+    {
+        xml_reader.LoadSceneFromFile(file, QStringRef(&local_path), scene, total_integrator);
+        integrator = &total_integrator;
+    }
+    else if(QString::compare(integrator_type, QString("direct"), Qt::CaseInsensitive) == 0)
+    {
+        xml_reader.LoadSceneFromFile(file, QStringRef(&local_path), scene, direct_integrator);
+        integrator = &direct_integrator;
+    }
+    else
+    {
+        std::cerr << "Unknown integrator " << integrator_type.toStdString() << std::endl;
+        return 1;
+    }
+    if(scene.objects.isEmpty())
+    {
+        std::cerr << "No geometry was loaded from " << arguments[0].toStdString() << std::endl;
+        return 1;
+    }
+
+    if(parser.isSet(threads_option))
+    {
+        scene.render_options.thread_count = parser.value(threads_option).toInt();
+    }
+    if(parser.isSet(samples_option))
+    {
+        scene.render_options.max_samples = parser.value(samples_option).toInt();
+    }
+    if(parser.isSet(bvh_benchmark_option))
+    {
+        scene.bvh_options.benchmark = true;
+    }
+
+    IntersectionEngine intersection_engine;
+    integrator->scene = &scene;
+    integrator->intersection_engine = &intersection_engine;
+    intersection_engine.scene = &scene;
+    intersection_engine.BuildBVH(scene.bvh_options);
+    if(parser.isSet(bvh_benchmark_option))
+    {
+        scene.Clear();
+        bvhNode::DeleteTree(intersection_engine.bvh);
+        return 0;
+    }
+    if(integrator == &photon_map_integrator)
+    {
+        photon_map_integrator.PrePass();
+    }
+    if(parser.isSet(benchmark_option))
+    {
+        photon_map_integrator.BenchmarkLookups(parser.value(benchmark_option).toInt());
+        scene.Clear();
+        bvhNode::DeleteTree(intersection_engine.bvh);
+        return 0;
+    }
+    for(Geometry *object : scene.objects)
+    {
+        if(object->material->is_volumetric)
+        {
+            ((VolumetricMaterial *)object->material)->CalculateDensities(object);
+        }
+    }
+
+    if(integrator == &sppm_integrator)
+    {
+        //SPPM keeps statistics per pixel between its iterations, so it renders the film itself
+        sppm_integrator.Render();
+        scene.film.WriteImage(parser.value(output_option));
+    }
+    else
+    {
+        Renderer renderer;
+        renderer.Begin(&scene, integrator, NULL);
+        renderer.Render();
+        renderer.PrintStats();
+        renderer.WriteImages(parser.value(output_option));
+    }
+
+    scene.Clear();
+    bvhNode::DeleteTree(intersection_engine.bvh);
+    return 0;
+}
@@ -1,38 +1,66 @@
 #include <renderthread.h>
-#include <QOpenGLFramebufferObject>
-#include <raytracing/samplers/stratifiedpixelsampler.h>
+#include <chrono>
 
-std::mutex mutx;
-
-RenderThread::RenderThread(unsigned int xstart, unsigned int xend, unsigned int ystart, unsigned int yend, unsigned int samplesSqrt, unsigned int depth, Film *f, Camera *c, Integrator *i, QImage& p_img)
-    : x_start(xstart), x_end(xend), y_start(ystart), y_end(yend), samples_sqrt(samplesSqrt), max_depth(depth), film(f), camera(c), integrator(i), image(p_img)
+RenderThread::RenderThread(TileScheduler *s, int worker_index, unsigned int samplesPerPixel, SamplerType samplerType, unsigned int depth, Film *f, Camera *c, Integrator *i, PreviewQueue *preview_queue)
+    : scheduler(s), worker(worker_index), samples_per_pixel(samplesPerPixel), sampler_type(samplerType), max_depth(depth), film(f), camera(c), integrator(i), preview(preview_queue)
 {}
 
 void RenderThread::run()
 {
-    unsigned int seed = (((x_start << 16 | x_end) ^ x_start) * ((y_start << 16 | y_end) ^ y_start));
-    StratifiedPixelSampler pixel_sampler(samples_sqrt, seed);
+    Sampler* sampler = CreateSampler(sampler_type, samples_per_pixel);
+    RenderTile tile;
+    while(scheduler->NextTile(worker, tile))
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        TraceTile(tile, *sampler);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        scheduler->FinishTile(worker, tile, elapsed.count());
+    }
+    delete sampler;
+}
 
-    for(unsigned int Y = y_start; Y < y_end; Y++)
+void RenderThread::TraceTile(const RenderTile &tile, Sampler &sampler)
+{
+    //Samples are splatted into a private tile and merged into the film in one go at the end
+    FilmTile film_tile = film->GetFilmTile(tile.x_start, tile.x_end, tile.y_start, tile.y_end);
+    for(unsigned int Y = tile.y_start; Y < tile.y_end; Y++)
     {
-        for(unsigned int X = x_start; X < x_end; X++)
+        for(unsigned int X = tile.x_start; X < tile.x_end; X++)
         {
-            glm::vec3 pixel_color;
-            QList<glm::vec2> samples = pixel_sampler.GetSamples(X, Y);
-            for(int i = 0; i < samples.size(); i++)
+            //Adaptive sampling has decided this pixel has enough samples
+            if(film->IsConverged(X, Y))
             {
-                Ray ray = camera->Raycast(samples[i]);
-                pixel_color += integrator->TraceRay(ray, 0, X, Y);
+                continue;
+            }
+            int sample_end = tile.first_sample + tile.sample_count;
+            for(int i = tile.first_sample; i < sample_end; i++)
+            {
+                //Samples depend only on the pixel and index, so the image doesn't depend on which thread renders it
+                sampler.StartPixelSample(glm::ivec2(X, Y), i);
+                glm::vec2 film_sample = glm::vec2(X, Y) + sampler.Get2D();
+                glm::vec2 lens_sample = sampler.Get2D();
+                Ray ray = camera->Raycast(film_sample, lens_sample);
+                AOVSample aovs;
+                glm::vec3 radiance = integrator->TraceRay(ray, 0, sampler, &aovs);
+                film_tile.AddSample(film_sample, radiance, &aovs);
             }
-            pixel_color /= samples.size();
-            film->pixels[X][Y] = pixel_color;
-            if(pixel_color.x > 1.f) pixel_color.x = 1.f;
-            if(pixel_color.y > 1.f) pixel_color.y = 1.f;
-            if(pixel_color.z > 1.f) pixel_color.z = 1.f;
-
-            mutx.lock();
-            image.setPixel(X, Y, qRgb(pixel_color.x * 255, pixel_color.y * 255 , pixel_color.z * 255));
-            mutx.unlock();
         }
     }
+    film->MergeFilmTile(film_tile);
+    if(preview == NULL)
+    {
+        return;
+    }
+
+    //Only this thread touches the tile's colors until it is pushed. They show every pass so far, though
+    //pixels on the tile's border may still be missing this pass's samples from neighbouring tiles.
+    PreviewTile* preview_tile = new PreviewTile(tile);
+    film->GetPixels(tile.x_start, tile.x_end, tile.y_start, tile.y_end, preview_tile->colors.data());
+    for(glm::vec3 &pixel_color : preview_tile->colors)
+    {
+        if(pixel_color.x > 1.f) pixel_color.x = 1.f;
+        if(pixel_color.y > 1.f) pixel_color.y = 1.f;
+        if(pixel_color.z > 1.f) pixel_color.z = 1.f;
+    }
+    preview->Push(preview_tile);
 }
@@ -6,28 +6,33 @@
 #include <raytracing/Integrator.h>
 #include <raytracing/directlightingintegrator.h>
 #include <raytracing/totallightingintegrator.h>
-#include <mutex>
+#include <raytracing/tilescheduler.h>
+#include <raytracing/previewqueue.h>
+#include <raytracing/samplers/sampler.h>
 
 class RenderThread : public QThread
 {
 public:
-    RenderThread(unsigned int xstart, unsigned int xend,
-            unsigned int ystart, unsigned int yend,
-            unsigned int samplesSqrt, unsigned int depth,
-            Film* f, Camera* c, Integrator* i, QImage& p_img);
+    RenderThread(TileScheduler* s, int worker_index,
+            unsigned int samplesPerPixel, SamplerType samplerType, unsigned int depth,
+            Film* f, Camera* c, Integrator* i, PreviewQueue* preview_queue);
 
 protected:
     //This overrides the functionality of QThread::run
     virtual void run();
-    glm::vec3 TraceRay(Ray r, unsigned int depth);// IntersectionEngine* intersection_engine, Scene* scene);
+    //Takes the tile's samples of every pixel in it, merges them into the film, then pushes the tile's
+    //running colors to the preview queue
+    void TraceTile(const RenderTile &tile, Sampler &sampler);
 
 
 
-    unsigned int x_start, x_end, y_start, y_end;
-    unsigned int samples_sqrt;//The square root of the number of rays to cast per pixel
+    TileScheduler* scheduler;
+    int worker;//This thread's index in the scheduler's workers
+    unsigned int samples_per_pixel;//The most samples any pixel gets over the whole render
+    SamplerType sampler_type;//The kind of sampler this thread makes for itself
     unsigned int max_depth;
     Film* film;
     Camera* camera;
     Integrator* integrator;
-    QImage& image;
+    PreviewQueue* preview;//NULL when nothing shows the render as it progresses
 };
@@ -175,7 +175,19 @@ Ray Camera::Raycast(float x, float y)
     return RaycastNDC(ndc_x, ndc_y);
 }
 
+Ray Camera::Raycast(const glm::vec2 &pt, const glm::vec2 &lens_sample)
+{
+    float ndc_x = (2*pt.x/width - 1);
+    float ndc_y = (1 - 2*pt.y/height);
+    return RaycastNDC(ndc_x, ndc_y, lens_sample);
+}
+
 Ray Camera::RaycastNDC(float ndc_x, float ndc_y)
+{
+    return RaycastNDC(ndc_x, ndc_y, glm::vec2(0.5f, 0.5f));
+}
+
+Ray Camera::RaycastNDC(float ndc_x, float ndc_y, const glm::vec2 &lens_sample)
 {
     glm::vec3 P = ref + ndc_x*H + ndc_y*V;
     Ray result(eye, P - eye);
@@ -187,9 +199,7 @@ Ray Camera::RaycastNDC(float ndc_x, float ndc_y)
         // it to a 2D disk centered at the origin (0,0), then scale by the
         // lens radius
         float lens_u, lens_v;
-        float r1 = float(rand()) / float(RAND_MAX);
-        float r2 = float(rand()) / float(RAND_MAX);
-        ConcentricSampleDisk(r1, r2, lens_u, lens_v);
+        ConcentricSampleDisk(lens_sample.x, lens_sample.y, lens_u, lens_v);
         lens_u *= lens_radius;
         lens_v *= lens_radius;
 
@@ -201,11 +211,26 @@ Ray Camera::RaycastNDC(float ndc_x, float ndc_y)
         result.origin = glm::vec3(result.origin.x + lens_u, result.origin.y + lens_v, result.origin.z);
         result.direction = glm::normalize(point_of_focus - result.origin);
     }
+    SetClipRange(result);
     return result;
 }
 
+//Turns the near and far clip planes into the range of distances along the ray that may be hit,
+//so that intersection tests never need the view matrix.
+void Camera::SetClipRange(Ray &r) const
+{
+    float depth_per_t = glm::dot(r.direction, look);
+    float origin_depth = glm::dot(r.origin - eye, look);
+    r.t_min = (near_clip - origin_depth) / depth_per_t;
+    r.t_max = (far_clip - origin_depth) / depth_per_t;
+}
+
 void Camera::create()
 {
+    if(!glEnabled())
+    {
+        return;
+    }
     std::vector<glm::vec3> pos;
     std::vector<glm::vec3> col;
     std::vector<GLuint> idx;
@@ -1,4 +1,5 @@
 #include "boundingbox.h"
+#include <scene/geometry/bvhsplit.h>
 #include <la.h>
 #include <iostream>
 
@@ -13,6 +14,11 @@ int BoundingBox::MaximumExtent() const {
     }
 }
 
+float BoundingBox::SurfaceArea() const {
+    glm::vec3 diagonal = maximum - minimum;
+    return 2.0f * (diagonal.x * diagonal.y + diagonal.y * diagonal.z + diagonal.z * diagonal.x);
+}
+
 BoundingBox BoundingBox::Union(const BoundingBox &b, const glm::vec3 &p) {
     BoundingBox ret = b;
     ret.minimum.x = fmin(b.minimum.x, p.x);
@@ -152,6 +158,9 @@ void createCubeIndices(std::vector<GLuint> (&cub_idx))
 }
 
 void BoundingBox::create() {
+    if(!glEnabled()) {
+        return;
+    }
 
     std::vector<GLuint> cub_idx;
     std::vector<glm::vec3> cub_vert_pos;
@@ -186,47 +195,84 @@ GLenum BoundingBox::drawMode() {
     return GL_LINES;
 }
 
-struct ComparePoints {
-    ComparePoints(int d) {dim = d;}
-    int dim;
-    bool operator()(bvhNode *a, bvhNode *b) const {
-        return a->bounding_box.center[dim] < b->bounding_box.center[dim];
+// Makes a leaf holding every primitive in [start_idx, end_idx].
+static bvhNode *CreateLeaf(std::vector<bvhNode*> &leaves, int start_idx, int end_idx) {
+    bvhNode *node = new bvhNode();
+    node->bounding_box = leaves[start_idx]->bounding_box;
+    for (int i=start_idx; i <= end_idx; i++) {
+        node->bounding_box = BoundingBox::Union(node->bounding_box, leaves[i]->bounding_box);
+        node->primitives.push_back(leaves[i]);
     }
-};
+    node->bounding_box.create();
+    return node;
+}
+
+static const BoundingBox &LeafBounds(bvhNode *leaf) {
+    return leaf->bounding_box;
+}
 
-bvhNode *bvhNode::CreateTree(std::vector<bvhNode*> &leaves, int depth, int start_idx, int end_idx) {
+bvhNode *bvhNode::CreateTree(std::vector<bvhNode*> &leaves, int depth, int start_idx, int end_idx,
+                             const BVHBuildOptions &options) {
+    // The tree may be flattened into a LinearBVH, whose leaves can't count more primitives than this.
+    if (options.max_leaf_size < 1 || options.max_leaf_size > BVH_MAX_LEAF_SIZE) {
+        BVHBuildOptions clamped_options = options;
+        clamped_options.max_leaf_size = glm::clamp(options.max_leaf_size, 1, BVH_MAX_LEAF_SIZE);
+        return CreateTree(leaves, depth, start_idx, end_idx, clamped_options);
+    }
     // If leaf node, then simply return bounding box.
     if (end_idx == start_idx) {
         return leaves[start_idx];
     }
 
-    // Pick best dimension.
-    // TODO: implement SAH heuristic once I finish animation hw.
-    BoundingBox centroidBounds;
-    for (int i=start_idx; i < end_idx; i++) {
-        centroidBounds = BoundingBox::Union(centroidBounds, leaves[i]->bounding_box);
+    int count = end_idx - start_idx + 1;
+    BVHItemBounds bounds = ComputeBVHItemBounds(&leaves[start_idx], count, LeafBounds);
+    int dimension;
+    int left_count = SplitBVHItems(&leaves[start_idx], count, depth, options,
+                                   LeafBounds, bounds, dimension);
+    if (left_count == 0) {
+        return CreateLeaf(leaves, start_idx, end_idx);
     }
-    int dimension = centroidBounds.MaximumExtent();
-
-    int mid = (end_idx+start_idx)/2;
-    std::nth_element(&leaves[start_idx], &leaves[mid], &leaves[end_idx]+1, ComparePoints(dimension));
+    int mid = start_idx + left_count - 1;
 
     bvhNode *node = new bvhNode();
     node->dimension = dimension;
-    node->left = CreateTree(leaves, depth+1, start_idx, mid);
-    node->right = CreateTree(leaves, depth+1, mid+1, end_idx);
+    node->left = CreateTree(leaves, depth+1, start_idx, mid, options);
+    node->right = CreateTree(leaves, depth+1, mid+1, end_idx, options);
     node->bounding_box = BoundingBox::Union(node->left->bounding_box,
                                             node->right->bounding_box);
     node->bounding_box.create();
     return node;
 }
 
-bvhNode *bvhNode::InitTree(QList<Geometry*> objects) {
+bvhNode *bvhNode::InitTree(QList<Geometry*> objects, const BVHBuildOptions &options) {
     std::vector<bvhNode*> leaves;
     foreach (Geometry *object, objects) {
-        leaves.push_back(object->SetBoundingBox());
+        leaves.push_back(object->SetBoundingBox(options));
+    }
+    return CreateTree(leaves, 0, 0, leaves.size()-1, options);
+}
+
+static float SAHCostRecursive(bvhNode *node, const BVHBuildOptions &options) {
+    if (node == NULL) {
+        return 0.0f;
+    }
+    float area = node->bounding_box.SurfaceArea();
+    if (node->bounding_box.object) {
+        return area * options.intersection_cost;
+    }
+    if (!node->primitives.empty()) {
+        return area * options.intersection_cost * node->primitives.size();
+    }
+    return area * options.traversal_cost
+            + SAHCostRecursive(node->left, options)
+            + SAHCostRecursive(node->right, options);
+}
+
+float bvhNode::SAHCost(bvhNode *root, const BVHBuildOptions &options) {
+    if (root == NULL || root->bounding_box.SurfaceArea() <= 0.0f) {
+        return 0.0f;
     }
-    return CreateTree(leaves, 0, 0, leaves.size()-1);
+    return SAHCostRecursive(root, options) / root->bounding_box.SurfaceArea();
 }
 
 void bvhNode::FlattenTree(bvhNode *root, std::vector<bvhNode*> &nodes) {
@@ -234,35 +280,43 @@ void bvhNode::FlattenTree(bvhNode *root, std::vector<bvhNode*> &nodes) {
         return;
     }
     nodes.push_back(root);
+    for (bvhNode *primitive : root->primitives) {
+        FlattenTree(primitive, nodes);
+    }
     FlattenTree(root->left, nodes);
     FlattenTree(root->right, nodes);
 }
 
-Intersection bvhNode::GetIntersection(Ray r, Camera &camera)
+Intersection bvhNode::GetIntersection(Ray r)
 {
     Intersection intersection;
     if (!bounding_box.GetIntersection(r)) {
         return intersection;
     }
-    if (bounding_box.object) {
-        Intersection current = bounding_box.object->GetIntersection(r, camera);
-        if (current.object_hit) {
-            // Transform point into camera space to check for clipping.
-            glm::vec3 world_point = glm::vec3(camera.ViewMatrix()
-                                              * glm::vec4(current.point, 1.0f));
-            if (world_point.z > camera.near_clip
-                && world_point.z < camera.far_clip) {
+    if (!primitives.empty()) {
+        for (bvhNode *primitive : primitives) {
+            Intersection current = primitive->GetIntersection(r);
+            if (current.object_hit && current.t >= r.t_min && current.t < r.t_max
+                    && (!intersection.object_hit || current.t < intersection.t)) {
                 intersection = current;
             }
         }
         return intersection;
     }
+    if (bounding_box.object) {
+        Intersection current = bounding_box.object->GetIntersection(r);
+        // Hits outside the ray's range, e.g. beyond the camera's clip planes, are dropped.
+        if (current.object_hit && current.t >= r.t_min && current.t < r.t_max) {
+            intersection = current;
+        }
+        return intersection;
+    }
 
     Intersection child0, child1;
     if (left)
-        child0 = left->GetIntersection(r, camera);
+        child0 = left->GetIntersection(r);
     if (right)
-        child1 = right->GetIntersection(r, camera);
+        child1 = right->GetIntersection(r);
 
     if (left && child0.object_hit) {
         intersection = child0;
@@ -281,6 +335,9 @@ void bvhNode::DeleteTree(bvhNode * root) {
         return;
     }
 
+    for (bvhNode *primitive : root->primitives) {
+        DeleteTree(primitive);
+    }
     DeleteTree(root->left);
     DeleteTree(root->right);
     delete root;
@@ -2,12 +2,14 @@
 
 #include <openGL/drawable.h>
 #include <scene/geometry/geometry.h>
+#include <scene/geometry/bvhbuildoptions.h>
 #include <scene/camera.h>
 #include <raytracing/intersection.h>
 #include <raytracing/ray.h>
 
 class Geometry;
 class Intersection;
+
 class BoundingBox : public Drawable
 {
 public:
@@ -24,6 +26,7 @@ public:
     static BoundingBox Union(const BoundingBox &b, const glm::vec3 &p);
     void SetNormals();
     int MaximumExtent() const;
+    float SurfaceArea() const;
 
     glm::vec3 center;
     glm::vec3 minimum;
@@ -43,14 +46,19 @@ public:
         dimension = -1;
     }
 
-    static bvhNode *CreateTree(std::vector<bvhNode*> &leaves, int depth, int start_idx, int end_idx);
-    static bvhNode *InitTree(QList<Geometry*> objects);
+    static bvhNode *CreateTree(std::vector<bvhNode*> &leaves, int depth, int start_idx, int end_idx,
+                               const BVHBuildOptions &options = BVHBuildOptions());
+    static bvhNode *InitTree(QList<Geometry*> objects, const BVHBuildOptions &options = BVHBuildOptions());
     static void DeleteTree(bvhNode * root);
     static void FlattenTree(bvhNode *root, std::vector<bvhNode*> &nodes);
-    Intersection GetIntersection(Ray r, Camera &camera);
+    //Returns the expected cost of tracing a ray through the tree under the surface area heuristic.
+    static float SAHCost(bvhNode *root, const BVHBuildOptions &options = BVHBuildOptions());
+    Intersection GetIntersection(Ray r);
 
     BoundingBox bounding_box;
     bvhNode *left;
     bvhNode *right;
     int dimension;
+    //Leaves holding more than one primitive keep the primitives' own nodes here.
+    std::vector<bvhNode*> primitives;
 };
@@ -0,0 +1,35 @@
+#pragma once
+
+//Deepest tree the iterative BVH traversal stack can hold. Builders fall back to median
+//splits below half this depth so that no tree can exceed it.
+#define BVH_MAX_DEPTH 64
+
+//Nodes with at least this many primitives have their bounds and SAH bins computed on several threads.
+#define BVH_PARALLEL_BIN_COUNT 65536
+//Subtrees over at least this many primitives are built as separate tasks by LinearBVH::Build.
+#define BVH_PARALLEL_TASK_COUNT 4096
+
+//Largest max_leaf_size a build accepts, since LinearBVHNode stores a leaf's primitive count in 16 bits.
+#define BVH_MAX_LEAF_SIZE 65535
+
+//The strategies bvhNode::CreateTree can use to partition a node's primitives.
+enum BVHSplitMethod {
+    BVH_SPLIT_MEDIAN,   //Object median along the longest axis of the centroid bounds.
+    BVH_SPLIT_SAH       //Binned surface area heuristic.
+};
+
+//Settings that control how a BVH is built. These are read from the scene file's <bvh> tag.
+struct BVHBuildOptions {
+    BVHBuildOptions():
+    split_method(BVH_SPLIT_SAH), max_leaf_size(4), bin_count(16),
+    traversal_cost(1.0f), intersection_cost(1.0f), branching_factor(2), thread_count(0), benchmark(false) {}
+
+    BVHSplitMethod split_method;
+    int max_leaf_size;          //Nodes holding at most this many primitives may become leaves. 1 to BVH_MAX_LEAF_SIZE.
+    int bin_count;              //Number of centroid bins evaluated per axis by the SAH builder.
+    float traversal_cost;       //Relative cost of visiting an interior node.
+    float intersection_cost;    //Relative cost of intersecting a single primitive.
+    int branching_factor;       //Children per node rays are traced through: 2, or 4/8 to collapse the scene's and every mesh's BVH.
+    int thread_count;           //Threads LinearBVH::Build may use. 0 uses every core.
+    bool benchmark;             //Time every mesh BVH build at 1, 2, 4, 8 and 16 threads and print the speedups.
+};
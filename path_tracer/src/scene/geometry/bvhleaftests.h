@@ -0,0 +1,53 @@
+#pragma once
+
+#include <scene/geometry/geometry.h>
+#include <raytracing/intersection.h>
+
+//Leaf tests for scene level BVHs, whose leaves hold ranges of Geometry pointers. They are shared
+//by every traversal backend, which calls them as leaf_test(offset, count, t_max).
+
+//Keeps the closest hit inside the ray's [t_min, t_max) range. Traversal starts with t_max = r.t_max.
+//Each primitive is handed the range left, so a mesh can prune its own BVH by the closest hit so far.
+struct ClosestHitTest {
+    ClosestHitTest(Geometry * const *primitives, const Ray &r) : primitives(primitives), r(r) {}
+
+    bool operator()(int offset, int count, float &t_max) {
+        for (int i=0; i < count; i++) {
+            r.t_max = t_max;
+            Intersection current = primitives[offset + i]->GetIntersection(r);
+            if (current.object_hit == NULL || current.t < r.t_min || current.t >= t_max) {
+                continue;
+            }
+            result = current;
+            t_max = current.t;
+        }
+        return false;
+    }
+
+    Geometry * const *primitives;
+    Ray r;
+    Intersection result;
+};
+
+struct AnyHitTest {
+    AnyHitTest(Geometry * const *primitives, const Ray &r) : primitives(primitives), r(r), hit(false) {}
+
+    bool operator()(int offset, int count, float &t_max) {
+        for (int i=0; i < count; i++) {
+            Geometry *geometry = primitives[offset + i];
+            // Light passes through transmissive objects, so they never block shadow rays.
+            if (geometry->material->isTransmissive()) {
+                continue;
+            }
+            if (geometry->IntersectsBefore(r, t_max)) {
+                hit = true;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    Geometry * const *primitives;
+    const Ray &r;
+    bool hit;
+};
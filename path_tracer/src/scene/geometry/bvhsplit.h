@@ -0,0 +1,207 @@
+#pragma once
+
+#include <la.h>
+#include <scene/geometry/bvhbuildoptions.h>
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <vector>
+
+//Split selection shared by the BVH builders. Items are anything the builder sorts (bvhNode
+//pointers, BVHPrimitives, ...); get_bounds(item) must return an object with glm::vec3
+//minimum, maximum and center members.
+
+inline float BVHBoxArea(const glm::vec3 &minimum, const glm::vec3 &maximum) {
+    glm::vec3 d = maximum - minimum;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+struct SAHBin {
+    SAHBin() : count(0), minimum(std::numeric_limits<float>::infinity()),
+        maximum(-std::numeric_limits<float>::infinity()) {}
+    int count;
+    glm::vec3 minimum;
+    glm::vec3 maximum;
+};
+
+// Bounds of a set of items and of their centroids.
+struct BVHItemBounds {
+    BVHItemBounds() : bounds_min(std::numeric_limits<float>::infinity()),
+        bounds_max(-std::numeric_limits<float>::infinity()),
+        centroid_min(std::numeric_limits<float>::infinity()),
+        centroid_max(-std::numeric_limits<float>::infinity()) {}
+
+    template <typename Bounds>
+    void Grow(const Bounds &b) {
+        bounds_min = glm::min(bounds_min, b.minimum);
+        bounds_max = glm::max(bounds_max, b.maximum);
+        centroid_min = glm::min(centroid_min, b.center);
+        centroid_max = glm::max(centroid_max, b.center);
+    }
+    void Merge(const BVHItemBounds &other) {
+        bounds_min = glm::min(bounds_min, other.bounds_min);
+        bounds_max = glm::max(bounds_max, other.bounds_max);
+        centroid_min = glm::min(centroid_min, other.centroid_min);
+        centroid_max = glm::max(centroid_max, other.centroid_max);
+    }
+
+    glm::vec3 bounds_min;
+    glm::vec3 bounds_max;
+    glm::vec3 centroid_min;
+    glm::vec3 centroid_max;
+};
+
+// Runs body(slice, begin, end) over slice_count contiguous slices of [0, count), each on its own
+// thread except the last, which runs on the calling thread.
+template <typename Body>
+void ForBVHSlices(int count, int slice_count, Body body)
+{
+    std::vector<std::thread> threads;
+    for (int slice=0; slice < slice_count - 1; slice++) {
+        threads.push_back(std::thread(body, slice, count * slice / slice_count,
+                                      count * (slice + 1) / slice_count));
+    }
+    body(slice_count - 1, count * (slice_count - 1) / slice_count, count);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+// Bounds items[0, count), on thread_count threads when there are at least BVH_PARALLEL_BIN_COUNT items.
+template <typename Item, typename GetBounds>
+BVHItemBounds ComputeBVHItemBounds(const Item *items, int count, GetBounds get_bounds, int thread_count = 1)
+{
+    int slice_count = count >= BVH_PARALLEL_BIN_COUNT ? glm::max(thread_count, 1) : 1;
+    if (slice_count == 1) {
+        BVHItemBounds result;
+        for (int i=0; i < count; i++) {
+            result.Grow(get_bounds(items[i]));
+        }
+        return result;
+    }
+    std::vector<BVHItemBounds> slice_bounds(slice_count);
+    ForBVHSlices(count, slice_count, [&](int slice, int begin, int end) {
+        for (int i=begin; i < end; i++) {
+            slice_bounds[slice].Grow(get_bounds(items[i]));
+        }
+    });
+    for (int slice=1; slice < slice_count; slice++) {
+        slice_bounds[0].Merge(slice_bounds[slice]);
+    }
+    return slice_bounds[0];
+}
+
+// Returns the bin a centroid falls into along the given axis.
+inline int SAHBinIndex(float center, float centroid_min, float centroid_extent, int bin_count) {
+    int b = (int)(bin_count * ((center - centroid_min) / centroid_extent));
+    return glm::clamp(b, 0, bin_count - 1);
+}
+
+// Partitions items[0, count) for a BVH node at the given depth. Returns the number of items that go
+// to the left child, or 0 if the items should become a single leaf. axis receives the split axis.
+// item_bounds must be ComputeBVHItemBounds of the same items; callers need them for the node anyway.
+// Nodes with at least BVH_PARALLEL_BIN_COUNT items are binned on thread_count threads; the merged
+// results are exact, so the split does not depend on the thread count.
+template <typename Item, typename GetBounds>
+int SplitBVHItems(Item *items, int count, int depth, const BVHBuildOptions &options,
+                  GetBounds get_bounds, const BVHItemBounds &item_bounds, int &axis, int thread_count = 1)
+{
+    axis = 0;
+    if (count <= 1) {
+        return 0;
+    }
+    int slice_count = count >= BVH_PARALLEL_BIN_COUNT ? glm::max(thread_count, 1) : 1;
+
+    glm::vec3 bounds_min = item_bounds.bounds_min;
+    glm::vec3 bounds_max = item_bounds.bounds_max;
+    glm::vec3 centroid_min = item_bounds.centroid_min;
+    glm::vec3 centroid_extent = item_bounds.centroid_max - centroid_min;
+    int dimension = 2;
+    if (centroid_extent.x > centroid_extent.y && centroid_extent.x > centroid_extent.z) {
+        dimension = 0;
+    } else if (centroid_extent.y > centroid_extent.z) {
+        dimension = 1;
+    }
+    axis = dimension;
+
+    if (options.split_method == BVH_SPLIT_SAH && centroid_extent[dimension] > 0.0f
+            && depth < BVH_MAX_DEPTH / 2) {
+        // Sort the centroids into bins along the chosen axis.
+        int bin_count = glm::max(options.bin_count, 2);
+        std::vector<std::vector<SAHBin> > slice_bins(slice_count, std::vector<SAHBin>(bin_count));
+        ForBVHSlices(count, slice_count, [&](int slice, int begin, int end) {
+            std::vector<SAHBin> &bins = slice_bins[slice];
+            for (int i=begin; i < end; i++) {
+                const auto &bounds = get_bounds(items[i]);
+                int b = SAHBinIndex(bounds.center[dimension], centroid_min[dimension],
+                                    centroid_extent[dimension], bin_count);
+                bins[b].count++;
+                bins[b].minimum = glm::min(bins[b].minimum, bounds.minimum);
+                bins[b].maximum = glm::max(bins[b].maximum, bounds.maximum);
+            }
+        });
+        std::vector<SAHBin> &bins = slice_bins[0];
+        for (int slice=1; slice < slice_count; slice++) {
+            for (int b=0; b < bin_count; b++) {
+                bins[b].count += slice_bins[slice][b].count;
+                bins[b].minimum = glm::min(bins[b].minimum, slice_bins[slice][b].minimum);
+                bins[b].maximum = glm::max(bins[b].maximum, slice_bins[slice][b].maximum);
+            }
+        }
+
+        // Sweep from the right to collect the area and count above every split plane.
+        std::vector<float> right_area(bin_count - 1);
+        std::vector<int> right_count(bin_count - 1);
+        SAHBin right;
+        for (int b=bin_count - 1; b > 0; b--) {
+            right.count += bins[b].count;
+            right.minimum = glm::min(right.minimum, bins[b].minimum);
+            right.maximum = glm::max(right.maximum, bins[b].maximum);
+            right_count[b - 1] = right.count;
+            right_area[b - 1] = right.count > 0 ? BVHBoxArea(right.minimum, right.maximum) : 0.0f;
+        }
+
+        // Sweep from the left and evaluate the cost of splitting after each bin.
+        float inv_area = 1.0f / BVHBoxArea(bounds_min, bounds_max);
+        float best_cost = std::numeric_limits<float>::infinity();
+        int best_split = -1;
+        SAHBin left;
+        for (int b=0; b < bin_count - 1; b++) {
+            left.count += bins[b].count;
+            left.minimum = glm::min(left.minimum, bins[b].minimum);
+            left.maximum = glm::max(left.maximum, bins[b].maximum);
+            if (left.count == 0 || right_count[b] == 0) {
+                continue;
+            }
+            float cost = options.traversal_cost + options.intersection_cost * inv_area
+                    * (left.count * BVHBoxArea(left.minimum, left.maximum) + right_count[b] * right_area[b]);
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_split = b;
+            }
+        }
+
+        // Stop splitting when intersecting everything is no more expensive than the best split.
+        float leaf_cost = options.intersection_cost * count;
+        if (count <= options.max_leaf_size && leaf_cost <= best_cost) {
+            return 0;
+        }
+
+        if (best_split >= 0) {
+            Item *pivot = std::partition(items, items + count, [&](const Item &item) {
+                return SAHBinIndex(get_bounds(item).center[dimension], centroid_min[dimension],
+                                   centroid_extent[dimension], bin_count) <= best_split;
+            });
+            return (int)(pivot - items);
+        }
+    } else if (count <= options.max_leaf_size) {
+        return 0;
+    }
+
+    // Fall back to an object median split, e.g. when every centroid coincides.
+    int mid = count / 2;
+    std::nth_element(items, items + mid, items + count, [&](const Item &a, const Item &b) {
+        return get_bounds(a).center[dimension] < get_bounds(b).center[dimension];
+    });
+    return mid;
+}
@@ -50,7 +50,7 @@ glm::vec3 Cube::ComputeNormal(const glm::vec3 &P)
 }
 
 
-Intersection Cube::GetIntersection(Ray r, Camera &camera)
+Intersection Cube::GetIntersection(Ray r)
 {
     //Transform the ray
     Ray r_loc = r.GetTransformedCopy(transform.invT());
@@ -116,6 +116,36 @@ Intersection Cube::GetIntersection(Ray r, Camera &camera)
 }
 
 
+bool Cube::IntersectsBefore(Ray r, float t_max)
+{
+    Ray r_loc = r.GetTransformedCopy(transform.invT());
+    float t_n = -1000000;
+    float t_f = 1000000;
+    for(int i = 0; i < 3; i++){
+        if(r_loc.direction[i] == 0){
+            if(r_loc.origin[i] < -0.5f || r_loc.origin[i] > 0.5f){
+                return false;
+            }
+        }
+        float t0 = (-0.5f - r_loc.origin[i])/r_loc.direction[i];
+        float t1 = (0.5f - r_loc.origin[i])/r_loc.direction[i];
+        if(t0 > t1){
+            float temp = t1;
+            t1 = t0;
+            t0 = temp;
+        }
+        t_n = fmax(t_n, t0);
+        t_f = fmin(t_f, t1);
+    }
+    if(t_n >= t_f || t_f < 0)
+    {
+        return false;
+    }
+    float t_final = t_n >= 0 ? t_n : t_f;
+    return t_final < ObjectSpaceDistance(r, t_max);
+}
+
+
 void Cube::ComputeTangents(const glm::vec3 &normal,
                      glm::vec3 &tangent, glm::vec3 &bitangent)
 {
@@ -184,7 +214,7 @@ glm::vec2 Cube::GetUVCoordinates(const glm::vec3 &point)
 
 
 // Set min and max bounds for a bounding box.
-bvhNode *Cube::SetBoundingBox() {
+bvhNode *Cube::SetBoundingBox(const BVHBuildOptions &) {
     bvhNode *node = new bvhNode();
 
     glm::vec3 vertex0 = glm::vec3(transform.T() * glm::vec4(-0.5f, -0.5f, -0.5f, 1.0f));
@@ -342,6 +372,10 @@ void createCubeIndices(GLuint (&cub_idx)[CUB_IDX_COUNT])
 
 void Cube::create()
 {
+    if(!glEnabled())
+    {
+        return;
+    }
     GLuint cub_idx[CUB_IDX_COUNT];
     glm::vec3 cub_vert_pos[CUB_VERT_COUNT];
     glm::vec3 cub_vert_nor[CUB_VERT_COUNT];
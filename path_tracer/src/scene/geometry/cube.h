@@ -7,7 +7,8 @@
 class Cube : public Geometry
 {
 public:
-    Intersection GetIntersection(Ray r, Camera &camera);
+    Intersection GetIntersection(Ray r);
+    bool IntersectsBefore(Ray r, float t_max);
     virtual glm::vec2 GetUVCoordinates(const glm::vec3 &point);
     virtual glm::vec3 ComputeNormal(const glm::vec3 &P);
     virtual void ComputeTangents(const glm::vec3 &normal, glm::vec3 &tangent, glm::vec3 &bitangent);
@@ -15,7 +16,7 @@ public:
                                      const glm::vec3 &origin, const float rand1, const float rand2, const glm::vec3 &normal);
     virtual glm::vec3 SampleArea(const float rand1, const float rand2, const glm::vec3 &normal, bool inWorldSpace);
     virtual float CloudDensity(const glm::vec3 voxel, float noise, float step_size);
-    bvhNode *SetBoundingBox();
+    bvhNode *SetBoundingBox(const BVHBuildOptions &options);
     void create();
 
     virtual void ComputeArea();
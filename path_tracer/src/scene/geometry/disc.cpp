@@ -1,4 +1,5 @@
 #include <scene/geometry/disc.h>
+#include <helpers.h>
 
 void Disc::ComputeArea()
 {
@@ -14,7 +15,13 @@ Intersection Disc::SampleLight(const IntersectionEngine *intersection_engine,
     glm::vec3 world_point = SampleArea(rand1, rand2, normal, true);
     Ray r(origin, world_point-origin);
 
-    Intersection result = intersection_engine->GetIntersection(r);
+    //Intersect the light alone, then check that nothing opaque blocks the path to it.
+    Intersection result = GetIntersection(r);
+    if(result.object_hit == NULL
+            || intersection_engine->Occluded(r, result.t - OFFSET))
+    {
+        return Intersection();
+    }
     return result;
 }
 
@@ -25,7 +32,7 @@ glm::vec3 Disc::SampleArea(const float rand1, const float rand2, const glm::vec3
     return inWorldSpace ? glm::vec3(transform.T() * glm::vec4(point, 1)) : point;
 }
 
-Intersection Disc::GetIntersection(Ray r, Camera &camera)
+Intersection Disc::GetIntersection(Ray r)
 {
     //Transform the ray
     Ray r_loc = r.GetTransformedCopy(transform.invT());
@@ -54,6 +61,14 @@ Intersection Disc::GetIntersection(Ray r, Camera &camera)
     return result;
 }
 
+bool Disc::IntersectsBefore(Ray r, float t_max)
+{
+    Ray r_loc = r.GetTransformedCopy(transform.invT());
+    float t = glm::dot(glm::vec3(0,0,1), (glm::vec3(0.5f, 0.5f, 0) - r_loc.origin)) / glm::dot(glm::vec3(0,0,1), r_loc.direction);
+    glm::vec3 P = t * r_loc.direction + r_loc.origin;
+    return t > 0 && (P.x * P.x + P.y * P.y) <= 0.25f && t < ObjectSpaceDistance(r, t_max);
+}
+
 glm::vec2 Disc::GetUVCoordinates(const glm::vec3 &point)
 {
     return glm::vec2(point.x + 0.5f, point.y + 0.5f);
@@ -73,7 +88,7 @@ void Disc::ComputeTangents(const glm::vec3 &normal,
 
 
 // Set min and max bounds for a bounding box.
-bvhNode *Disc::SetBoundingBox() {
+bvhNode *Disc::SetBoundingBox(const BVHBuildOptions &) {
     bvhNode *node = new bvhNode();
 
     glm::vec3 vertex0 = glm::vec3(transform.T() * glm::vec4(-0.5f, -0.5f, 0.0f, 1.0f));
@@ -103,6 +118,10 @@ bvhNode *Disc::SetBoundingBox() {
 
 void Disc::create()
 {
+    if(!glEnabled())
+    {
+        return;
+    }
     GLuint idx[54];
     //18 tris, 54 indices
     glm::vec3 vert_pos[20];
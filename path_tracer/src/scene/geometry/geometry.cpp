@@ -16,6 +16,11 @@ float Geometry::RayPDF(const Intersection &isx, const Ray &ray, const Intersecti
     return pow(glm::length(light_intersection.point-ray.origin), 2.0f) / (theta * area);
 }
 
+float Geometry::ObjectSpaceDistance(const Ray &r, float t)
+{
+    return t * glm::length(glm::vec3(transform.invT() * glm::vec4(r.direction, 0.f)));
+}
+
 glm::vec3 Geometry::SamplePhotonDirectionFromLight(const float r1, const float r2, bool inWorldSpace)
 {
     glm::vec3 direction;
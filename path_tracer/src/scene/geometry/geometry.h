@@ -11,6 +11,7 @@
 
 class BoundingBox;
 class bvhNode;
+struct BVHBuildOptions;
 class Material;
 class Intersection;
 
@@ -19,13 +20,16 @@ class Geometry : public Drawable
 {
 public:
 //Constructors/destructors
-    Geometry() : name("GEOMETRY"), transform()
+    Geometry() : name("GEOMETRY"), transform(), id(-1)
     {
         material = NULL;
     }
 //Functions
     virtual ~Geometry(){}
-    virtual Intersection GetIntersection(Ray r, Camera &camera) = 0;
+    virtual Intersection GetIntersection(Ray r) = 0;
+    //Any-hit test for shadow rays: returns true if the ray hits this Geometry less than t_max
+    //(a world space distance) along it. Skips the normal, texture and tangent work of GetIntersection.
+    virtual bool IntersectsBefore(Ray r, float t_max) = 0;
     virtual void SetMaterial(Material* m){material = m;}
     virtual glm::vec2 GetUVCoordinates(const glm::vec3 &point) = 0;
     virtual glm::vec3 ComputeNormal(const glm::vec3 &P) = 0;
@@ -41,7 +45,9 @@ public:
             const float rand2,
             const glm::vec3 &normal,
             bool inWorldSpace) = 0;
-    virtual bvhNode *SetBoundingBox() = 0;
+    //Creates the BVH leaf for this geometry. Geometry made of many primitives (e.g. meshes)
+    //uses the options to build its own hierarchy.
+    virtual bvhNode *SetBoundingBox(const BVHBuildOptions &options) = 0;
     virtual float CloudDensity(const glm::vec3 voxel, float noise, float step_size);
     virtual float PyroclasticDensity(const glm::vec3 voxel, float noise, float step_size);
 
@@ -58,6 +64,10 @@ public:
     // Return a ray of photon from the light source
     virtual glm::vec3 SamplePhotonDirectionFromLight(const float r1, const float r2, bool inWorldSpace);
 
+    //Converts a distance t along the world space ray r into the distance along r.GetTransformedCopy(transform.invT()),
+    //whose direction is renormalized in object space.
+    float ObjectSpaceDistance(const Ray &r, float t);
+
 
 //Member variables
     QString name;//Mainly used for debugging purposes
@@ -65,4 +75,5 @@ public:
     Material* material;
     BoundingBox* bounding_box;
     float area;
+    int id;//Index in the scene's list of objects, set once the scene is loaded
 };
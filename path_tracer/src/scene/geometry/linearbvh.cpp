@@ -0,0 +1,159 @@
+#include <scene/geometry/linearbvh.h>
+#include <scene/geometry/geometry.h>
+#include <scene/geometry/boundingbox.h>
+#include <scene/geometry/bvhsplit.h>
+#include <scene/geometry/bvhleaftests.h>
+#include <limits>
+#include <thread>
+
+void LinearBVH::Clear()
+{
+    nodes.clear();
+    primitives.clear();
+}
+
+void LinearBVH::Flatten(bvhNode *root)
+{
+    Clear();
+    if (root != NULL) {
+        FlattenRecursive(root);
+    }
+}
+
+int LinearBVH::FlattenRecursive(bvhNode *node)
+{
+    int index = nodes.size();
+    nodes.push_back(LinearBVHNode());
+    LinearBVHNode linear_node;
+    linear_node.minimum = node->bounding_box.minimum;
+    linear_node.maximum = node->bounding_box.maximum;
+    linear_node.primitive_count = 0;
+    linear_node.axis = 0;
+    linear_node.pad = 0;
+
+    if (node->bounding_box.object) {
+        // Geometry leaves, including meshes whose own tree hangs below them.
+        linear_node.offset = primitives.size();
+        linear_node.primitive_count = 1;
+        primitives.push_back(node->bounding_box.object);
+    } else if (!node->primitives.empty()) {
+        linear_node.offset = primitives.size();
+        linear_node.primitive_count = node->primitives.size();
+        for (bvhNode *primitive : node->primitives) {
+            primitives.push_back(primitive->bounding_box.object);
+        }
+    } else {
+        linear_node.axis = node->dimension < 0 ? 0 : node->dimension;
+        FlattenRecursive(node->left);
+        linear_node.offset = FlattenRecursive(node->right);
+    }
+    nodes[index] = linear_node;
+    return index;
+}
+
+static const BVHPrimitive &PrimitiveBounds(const BVHPrimitive &primitive) {
+    return primitive;
+}
+
+void LinearBVH::Build(std::vector<BVHPrimitive> &build_primitives, const BVHBuildOptions &options)
+{
+    Clear();
+    if (!build_primitives.empty()) {
+        int thread_count = options.thread_count > 0 ? options.thread_count
+                                                    : glm::max((int)std::thread::hardware_concurrency(), 1);
+        // Larger leaves would overflow LinearBVHNode::primitive_count.
+        BVHBuildOptions build_options = options;
+        build_options.max_leaf_size = glm::clamp(options.max_leaf_size, 1, BVH_MAX_LEAF_SIZE);
+        nodes.reserve(2 * build_primitives.size());
+        BuildRecursive(build_primitives, nodes, 0, build_primitives.size(), 0, build_options, thread_count);
+    }
+}
+
+// Appends a subtree built on its own to out, moving its interior offsets along with it.
+static void AppendSubtree(std::vector<LinearBVHNode> &out, const std::vector<LinearBVHNode> &subtree)
+{
+    int base = out.size();
+    for (LinearBVHNode node : subtree) {
+        if (node.primitive_count == 0) {
+            node.offset += base;
+        }
+        out.push_back(node);
+    }
+}
+
+// Appends the subtree over build_primitives[start, end) to out in depth-first order and returns the
+// index of its root. While threads are left, each large child is built into its own array on its own
+// thread, with the threads shared out by primitive count, and spliced in once both are done.
+int LinearBVH::BuildRecursive(std::vector<BVHPrimitive> &build_primitives, std::vector<LinearBVHNode> &out,
+                              int start, int end, int depth, const BVHBuildOptions &options, int thread_count)
+{
+    int index = out.size();
+    out.push_back(LinearBVHNode());
+    int count = end - start;
+    BVHItemBounds bounds = ComputeBVHItemBounds(&build_primitives[start], count, PrimitiveBounds, thread_count);
+    LinearBVHNode node;
+    node.minimum = bounds.bounds_min;
+    node.maximum = bounds.bounds_max;
+    node.axis = 0;
+    node.pad = 0;
+
+    int axis;
+    int left_count = SplitBVHItems(&build_primitives[start], count, depth, options,
+                                   PrimitiveBounds, bounds, axis, thread_count);
+    if (left_count == 0 || left_count == count) {
+        node.offset = start;
+        node.primitive_count = count;
+    } else if (thread_count > 1 && count >= BVH_PARALLEL_TASK_COUNT) {
+        node.axis = axis;
+        node.primitive_count = 0;
+        int left_threads = glm::clamp((int)((long long)thread_count * left_count / count), 1, thread_count - 1);
+        std::vector<LinearBVHNode> left_nodes;
+        std::vector<LinearBVHNode> right_nodes;
+        std::thread left_task([&]() {
+            BuildRecursive(build_primitives, left_nodes, start, start + left_count, depth + 1, options, left_threads);
+        });
+        BuildRecursive(build_primitives, right_nodes, start + left_count, end, depth + 1, options,
+                       thread_count - left_threads);
+        left_task.join();
+        AppendSubtree(out, left_nodes);
+        node.offset = out.size();
+        AppendSubtree(out, right_nodes);
+    } else {
+        node.axis = axis;
+        node.primitive_count = 0;
+        BuildRecursive(build_primitives, out, start, start + left_count, depth + 1, options, 1);
+        node.offset = BuildRecursive(build_primitives, out, start + left_count, end, depth + 1, options, 1);
+    }
+    out[index] = node;
+    return index;
+}
+
+float LinearBVH::SAHCost(const BVHBuildOptions &options) const
+{
+    if (nodes.empty()) {
+        return 0.0f;
+    }
+    float cost = 0.0f;
+    for (const LinearBVHNode &node : nodes) {
+        float area = BVHBoxArea(node.minimum, node.maximum);
+        cost += node.primitive_count > 0 ? area * options.intersection_cost * node.primitive_count
+                                         : area * options.traversal_cost;
+    }
+    float root_area = BVHBoxArea(nodes[0].minimum, nodes[0].maximum);
+    return root_area > 0.0f ? cost / root_area : 0.0f;
+}
+
+Intersection LinearBVH::GetIntersection(const Ray &r) const
+{
+    ClosestHitTest closest_hit(primitives.data(), r);
+    float t_max = r.t_max;
+    Traverse(r, t_max, closest_hit);
+    return closest_hit.result;
+}
+
+bool LinearBVH::Occluded(const Ray &r, float t_max) const
+{
+    AnyHitTest any_hit(primitives.data(), r);
+    Traverse(r, t_max, any_hit);
+    return any_hit.hit;
+}
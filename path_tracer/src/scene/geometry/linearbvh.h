@@ -0,0 +1,120 @@
+#pragma once
+
+#include <la.h>
+#include <scene/geometry/bvhbuildoptions.h>
+#include <raytracing/ray.h>
+#include <vector>
+#include <cstdint>
+
+class bvhNode;
+class Geometry;
+class Intersection;
+
+//A BVH node packed into 32 bytes. Nodes are stored in depth-first order, so an interior
+//node's first child always directly follows it and only the second child's index is stored.
+struct LinearBVHNode {
+    glm::vec3 minimum;
+    glm::vec3 maximum;
+    int offset;                 //Leaves: index of the first primitive. Interior nodes: index of the second child.
+    uint16_t primitive_count;   //0 for interior nodes.
+    uint8_t axis;               //Split axis of interior nodes.
+    uint8_t pad;
+};
+
+static_assert(sizeof(LinearBVHNode) == 32, "LinearBVHNode should be 32 bytes");
+
+//Bounds of one primitive handed to LinearBVH::Build.
+struct BVHPrimitive {
+    glm::vec3 minimum;
+    glm::vec3 maximum;
+    glm::vec3 center;
+    int index;                  //The caller's index for the primitive.
+};
+
+//Pointer-free BVH used for ray traversal. It is either flattened from a bvhNode tree, in which
+//case leaves index into primitives, or built directly over BVHPrimitives.
+class LinearBVH
+{
+public:
+    //Replaces the contents of this BVH with a flattened copy of the given tree.
+    void Flatten(bvhNode *root);
+    //Builds the BVH over build_primitives, reordering them so that each leaf covers
+    //build_primitives[offset, offset + primitive_count). Large subtrees are built in parallel
+    //on up to options.thread_count threads; the tree is the same for any thread count.
+    void Build(std::vector<BVHPrimitive> &build_primitives, const BVHBuildOptions &options);
+    void Clear();
+    //Returns the expected cost of tracing a ray through the tree under the surface area heuristic.
+    float SAHCost(const BVHBuildOptions &options) const;
+
+    Intersection GetIntersection(const Ray &r) const;
+    //Returns true if a non-transmissive primitive is hit before t_max, stopping at the first one found.
+    bool Occluded(const Ray &r, float t_max) const;
+
+    //Walks every node the ray enters before t_max, nearer child first. leaf_test(offset, count, t_max)
+    //is called for each leaf reached with its range of primitives; it may shrink t_max to cull
+    //farther nodes, and returning true ends the traversal.
+    template <typename LeafTest>
+    void Traverse(const Ray &r, float &t_max, LeafTest &leaf_test) const;
+
+    std::vector<LinearBVHNode> nodes;
+    std::vector<Geometry*> primitives;
+
+private:
+    int FlattenRecursive(bvhNode *node);
+    static int BuildRecursive(std::vector<BVHPrimitive> &build_primitives, std::vector<LinearBVHNode> &out,
+                              int start, int end, int depth, const BVHBuildOptions &options, int thread_count);
+};
+
+inline bool IntersectBounds(const LinearBVHNode &node, const glm::vec3 &origin,
+                            const glm::vec3 &inv_dir, const int dir_is_neg[3], float t_max)
+{
+    const glm::vec3 *bounds[2] = {&node.minimum, &node.maximum};
+    float t0 = 0.0f;
+    float t1 = t_max;
+    for (int i=0; i < 3; ++i) {
+        float t_near = ((*bounds[dir_is_neg[i]])[i] - origin[i]) * inv_dir[i];
+        float t_far = ((*bounds[1 - dir_is_neg[i]])[i] - origin[i]) * inv_dir[i];
+        // Written so that a NaN from a ray lying in a slab plane leaves the interval unchanged.
+        t0 = t_near > t0 ? t_near : t0;
+        t1 = t_far < t1 ? t_far : t1;
+    }
+    return t0 <= t1;
+}
+
+template <typename LeafTest>
+void LinearBVH::Traverse(const Ray &r, float &t_max, LeafTest &leaf_test) const
+{
+    if (nodes.empty()) {
+        return;
+    }
+    glm::vec3 inv_dir = 1.0f / r.direction;
+    int dir_is_neg[3] = {inv_dir.x < 0, inv_dir.y < 0, inv_dir.z < 0};
+
+    int to_visit[BVH_MAX_DEPTH];
+    int to_visit_count = 0;
+    int current = 0;
+    while (true) {
+        const LinearBVHNode &node = nodes[current];
+        if (IntersectBounds(node, r.origin, inv_dir, dir_is_neg, t_max)) {
+            if (node.primitive_count > 0) {
+                if (leaf_test(node.offset, node.primitive_count, t_max)) {
+                    return;
+                }
+            } else {
+                // Visit the child on the near side of the split first.
+                if (dir_is_neg[node.axis]) {
+                    to_visit[to_visit_count++] = current + 1;
+                    current = node.offset;
+                } else {
+                    to_visit[to_visit_count++] = node.offset;
+                    current = current + 1;
+                }
+                continue;
+            }
+        }
+        if (to_visit_count == 0) {
+            break;
+        }
+        current = to_visit[--to_visit_count];
+    }
+}
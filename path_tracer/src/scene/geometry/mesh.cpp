@@ -2,36 +2,22 @@
 #include <la.h>
 #include <tinyobj/tiny_obj_loader.h>
 #include <iostream>
-
-void Triangle::ComputeArea()
-{
-    //Extra credit to implement this
-    glm::vec3 AB = points[1] - points[0];
-    glm::vec3 AC = points[2] - points[0];
-    area = glm::length(glm::cross(AB, AC)) / 2.0f;
-}
+#include <limits>
+#include <chrono>
+#include <cstring>
+#include <QSaveFile>
 
 void Mesh::ComputeArea()
 {
     //Extra credit to implement this
-    for (Geometry *face : faces) {
-        face->ComputeArea();
-        area += face->area;
+    area = 0;
+    for (unsigned int face = 0; face < vertex_indices.size() / 3; face++) {
+        glm::vec3 AB = FacePoint(face, 1) - FacePoint(face, 0);
+        glm::vec3 AC = FacePoint(face, 2) - FacePoint(face, 0);
+        area += glm::length(glm::cross(AB, AC)) / 2.0f;
     }
 }
 
-Intersection Triangle::SampleLight(const IntersectionEngine *intersection_engine,
-                                   const glm::vec3 &origin, const float rand1, const float rand2,
-                                   const glm::vec3 &normal)
-{
-    return Intersection();
-}
-
-glm::vec3 Triangle::SampleArea(const float rand1, const float rand2, const glm::vec3 &normal, bool inWorldSpace)
-{
-    return glm::vec3();
-}
-
 Intersection Mesh::SampleLight(const IntersectionEngine *intersection_engine,
                                const glm::vec3 &origin, const float x, const float y,
                                const glm::vec3 &normal)
@@ -44,68 +30,26 @@ glm::vec3 Mesh::SampleArea(const float rand1, const float rand2, const glm::vec3
     return glm::vec3();
 }
 
-Triangle::Triangle(const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3):
-    Triangle(p1, p2, p3, glm::vec3(1), glm::vec3(1), glm::vec3(1), glm::vec2(0), glm::vec2(0), glm::vec2(0))
-{
-    for(int i = 0; i < 3; i++)
-    {
-        normals[i] = plane_normal;
-    }
-}
-
-
-Triangle::Triangle(const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3, const glm::vec3 &n1, const glm::vec3 &n2, const glm::vec3 &n3):
-    Triangle(p1, p2, p3, n1, n2, n3, glm::vec2(0), glm::vec2(0), glm::vec2(0))
+glm::vec3 Mesh::ComputeNormal(const glm::vec3 &P)
 {}
 
+void Mesh::ComputeTangents(const glm::vec3 &normal,
+                     glm::vec3 &tangent, glm::vec3 &bitangent)
+{}
 
-Triangle::Triangle(const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3, const glm::vec3 &n1, const glm::vec3 &n2, const glm::vec3 &n3, const glm::vec2 &t1, const glm::vec2 &t2, const glm::vec2 &t3)
-{
-    plane_normal = glm::normalize(glm::cross(p2 - p1, p3 - p2));
-    points[0] = p1;
-    points[1] = p2;
-    points[2] = p3;
-    normals[0] = n1;
-    normals[1] = n2;
-    normals[2] = n3;
-    uvs[0] = t1;
-    uvs[1] = t2;
-    uvs[2] = t3;
-}
-
-float Area(const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3)
-{
-    return glm::length(glm::cross(p1 - p2, p3 - p2)) * 0.5f;
-}
-
-//Returns the interpolation of the triangle's three normals based on the point inside the triangle that is given.
-glm::vec3 Triangle::GetNormal(const glm::vec3 &P)
+glm::vec3 Mesh::FacePoint(int face, int corner) const
 {
-    float A = Area(points[0], points[1], points[2]);
-    float A0 = Area(points[1], points[2], P);
-    float A1 = Area(points[0], points[2], P);
-    float A2 = Area(points[0], points[1], P);
-    return glm::normalize(normals[0] * A0/A + normals[1] * A1/A + normals[2] * A2/A);
+    return vertex_positions[vertex_indices[3 * face + corner]];
 }
 
-glm::vec4 Triangle::GetNormal(const glm::vec4 &position)
+//Tangent and bitangent of a face follow the direction of its uv coordinates.
+void Mesh::FaceTangents(int face, glm::vec3 &tangent, glm::vec3 &bitangent) const
 {
-    glm::vec3 result = GetNormal(glm::vec3(position));
-    return glm::vec4(result, 0);
-}
-
-glm::vec3 Triangle::ComputeNormal(const glm::vec3 &P)
-{}
-glm::vec3 Mesh::ComputeNormal(const glm::vec3 &P)
-{}
-
-void Triangle::ComputeTangents(const glm::vec3 &normal,
-                     glm::vec3 &tangent, glm::vec3 &bitangent)
-{
-    glm::vec3 delta_pos0 = points[1] - points[0];
-    glm::vec3 delta_pos1 = points[2] - points[0];
-    glm::vec2 delta_uvs0 = uvs[1] - uvs[0];
-    glm::vec2 delta_uvs1 = uvs[2] - uvs[0];
+    const unsigned int *index = &vertex_indices[3 * face];
+    glm::vec3 delta_pos0 = vertex_positions[index[1]] - vertex_positions[index[0]];
+    glm::vec3 delta_pos1 = vertex_positions[index[2]] - vertex_positions[index[0]];
+    glm::vec2 delta_uvs0 = vertex_uvs[index[1]] - vertex_uvs[index[0]];
+    glm::vec2 delta_uvs1 = vertex_uvs[index[2]] - vertex_uvs[index[0]];
     tangent = (delta_uvs1.y * delta_pos0 - delta_uvs0.y * delta_pos1)
             / (delta_uvs1.y * delta_uvs0.x - delta_uvs0.y * delta_uvs1.x);
     if (delta_uvs1.y != 0) {
@@ -115,97 +59,111 @@ void Triangle::ComputeTangents(const glm::vec3 &normal,
     }
 }
 
-void Mesh::ComputeTangents(const glm::vec3 &normal,
-                     glm::vec3 &tangent, glm::vec3 &bitangent)
-{}
-
-//HAVE THEM IMPLEMENT THIS
-//The ray in this function is not transformed because it was *already* transformed in Mesh::GetIntersection
-Intersection Triangle::GetIntersection(Ray r, Camera &camera) {
-    //1. Ray-plane intersection
+//Surface attributes are interpolated with the barycentric coordinates returned by the packet test.
+Intersection Mesh::GetSurfaceIntersection(const Ray &r_loc, int face, float t, float u, float v)
+{
+    const unsigned int *index = &vertex_indices[3 * face];
+    float w = 1.0f - u - v;
     Intersection result;
-    float t =  glm::dot(plane_normal, (points[0] - r.origin)) / glm::dot(plane_normal, r.direction);
-
-    glm::vec3 P = r.origin + t * r.direction;
-    //2. Barycentric test
-    float S = 0.5f * glm::length(glm::cross(points[0] - points[1], points[0] - points[2]));
-    float s1 = 0.5f * glm::length(glm::cross(P - points[1], P - points[2]))/S;
-    float s2 = 0.5f * glm::length(glm::cross(P - points[2], P - points[0]))/S;
-    float s3 = 0.5f * glm::length(glm::cross(P - points[0], P - points[1]))/S;
-    float sum = s1 + s2 + s3;
-
-    if(s1 >= 0 && s1 <= 1 && s2 >= 0 && s2 <= 1 && s3 >= 0 && s3 <= 1 && fequal(sum, 1.0f)){
-        result.t = t;
-        result.texture_color = Material::GetImageColorInterp(GetUVCoordinates(glm::vec3(P)), material->texture);
-        result.object_hit = this;
-        // Store the tangent and bitangent
-        glm::vec3 tangent;
-        glm::vec3 bitangent;
-        ComputeTangents(plane_normal, tangent, bitangent);
-        result.tangent = glm::normalize(glm::vec3(transform.T() * glm::vec4(tangent, 0)));
-        result.bitangent = glm::normalize(glm::vec3(transform.T() * glm::vec4(bitangent, 0)));
-    }
+    result.t = t;
+    result.point = r_loc.origin + t * r_loc.direction;
+    result.normal = glm::normalize(w * vertex_normals[index[0]] + u * vertex_normals[index[1]]
+                                   + v * vertex_normals[index[2]]);
+    glm::vec2 uv = w * vertex_uvs[index[0]] + u * vertex_uvs[index[1]] + v * vertex_uvs[index[2]];
+    result.texture_color = Material::GetImageColorInterp(uv, material->texture);
+    result.object_hit = this;
+    // Store the tangent and bitangent
+    glm::vec3 tangent;
+    glm::vec3 bitangent;
+    FaceTangents(face, tangent, bitangent);
+    result.tangent = glm::normalize(glm::vec3(transform.T() * glm::vec4(tangent, 0)));
+    result.bitangent = glm::normalize(glm::vec3(transform.T() * glm::vec4(bitangent, 0)));
     return result;
 }
 
 
-bvhNode *Triangle::SetBoundingBox() {
-    bvhNode *node = new bvhNode();
-
-    glm::vec3 vertex0 = glm::vec3(transform.T() * glm::vec4(points[0], 1.0f));
-    glm::vec3 vertex1 = glm::vec3(transform.T() * glm::vec4(points[1], 1.0f));
-    glm::vec3 vertex2 = glm::vec3(transform.T() * glm::vec4(points[2], 1.0f));
-
-    float min_x = fmin(fmin(vertex0.x, vertex1.x), vertex2.x);
-    float min_y = fmin(fmin(vertex0.y, vertex1.y), vertex2.y);
-    float min_z = fmin(fmin(vertex0.z, vertex1.z), vertex2.z);
-    float max_x = fmax(fmax(vertex0.x, vertex1.x), vertex2.x);
-    float max_y = fmax(fmax(vertex0.y, vertex1.y), vertex2.y);
-    float max_z = fmax(fmax(vertex0.z, vertex1.z), vertex2.z);
-
-    bounding_box = &(node->bounding_box);
-    bounding_box->minimum = glm::vec3(min_x, min_y, min_z);
-    bounding_box->maximum = glm::vec3(max_x, max_y, max_z);
-    bounding_box->center = bounding_box->minimum
-            + (bounding_box->maximum - bounding_box->minimum)/ 2.0f;
-    bounding_box->object = this;
-    bounding_box->SetNormals();
-    bounding_box->create();
-
-    return node;
-}
-
+//Leaf test used to walk a mesh's triangle BVH for the closest hit.
+//Only the hit distance and barycentrics are kept; attributes are computed once for the winner.
+struct ClosestPacketTest {
+    ClosestPacketTest(const std::vector<TrianglePacket> &packets, const Ray &r, float t_min) :
+        packets(packets), r(r), t_min(t_min), face(-1) {}
+
+    bool operator()(int offset, int /*count*/, float &t_max) {
+        const TrianglePacket &packet = packets[offset];
+        float u, v;
+        int lane = IntersectTrianglePacket(packet, r.origin, r.direction, t_min, t_max, u, v);
+        if(lane >= 0){
+            face = packet.face[lane];
+            hit_u = u;
+            hit_v = v;
+        }
+        return false;
+    }
 
-Intersection Mesh::GetIntersection(Ray r, Camera &camera) {
+    const std::vector<TrianglePacket> &packets;
+    const Ray &r;
+    float t_min;
+    int face;
+    float hit_u;
+    float hit_v;
+};
+
+//The ray is transformed into object space once here and then traced through the mesh's own BVH,
+//which only reports hits inside the ray's [t_min, t_max) range.
+Intersection Mesh::GetIntersection(Ray r) {
     Ray r_loc = r.GetTransformedCopy(transform.invT());
-    Intersection closest;
-    for(int i = 0; i < faces.size(); i++){
-        Intersection isx = faces[i]->GetIntersection(r_loc, camera);
-        if(isx.object_hit != NULL && isx.t > 0 && (isx.t < closest.t || closest.t < 0)){
-            closest = isx;
-        }
+    //r_loc's direction is normalized again, so object space distances are world distances times this.
+    float object_scale = ObjectSpaceDistance(r, 1.0f);
+    ClosestPacketTest closest_packet(triangle_packets, r_loc, r.t_min * object_scale);
+    float t_max = r.t_max * object_scale;
+    if(!triangle_wide_bvh.nodes.empty())
+    {
+        triangle_wide_bvh.Traverse(r_loc, t_max, closest_packet);
     }
-    if(closest.object_hit != NULL)
+    else
     {
-        Triangle* tri = (Triangle*)closest.object_hit;
-        glm::vec4 P = glm::vec4(closest.t * r_loc.direction + r_loc.origin, 1);
-        closest.point = glm::vec3(transform.T() * P);
-        closest.normal = glm::normalize(glm::vec3(transform.invTransT() * tri->GetNormal(P)));
-        closest.object_hit = this;
-        closest.t = glm::distance(closest.point, r.origin);//The t used for the closest triangle test was in object space
-        // Store the tangent and bitangent
+        triangle_bvh.Traverse(r_loc, t_max, closest_packet);
     }
+    if(closest_packet.face < 0)
+    {
+        return Intersection();
+    }
+    Intersection closest = GetSurfaceIntersection(r_loc, closest_packet.face, t_max,
+                                                  closest_packet.hit_u, closest_packet.hit_v);
+    closest.point = glm::vec3(transform.T() * glm::vec4(closest.point, 1));
+    closest.normal = glm::normalize(glm::vec3(transform.invTransT() * glm::vec4(closest.normal, 0)));
+    closest.t = glm::distance(closest.point, r.origin);//The t used for the closest triangle test was in object space
     return closest;
 }
 
+//Leaf test used to walk a mesh's triangle BVH until any triangle is hit.
+struct AnyPacketTest {
+    AnyPacketTest(const std::vector<TrianglePacket> &packets, const Ray &r) :
+        packets(packets), r(r), hit(false) {}
 
-void Mesh::SetMaterial(Material *m)
-{
-    this->material = m;
-    for(Triangle *t : faces)
+    bool operator()(int offset, int /*count*/, float &t_max) {
+        hit = OccludedByTrianglePacket(packets[offset], r.origin, r.direction, t_max);
+        return hit;
+    }
+
+    const std::vector<TrianglePacket> &packets;
+    const Ray &r;
+    bool hit;
+};
+
+bool Mesh::IntersectsBefore(Ray r, float t_max) {
+    Ray r_loc = r.GetTransformedCopy(transform.invT());
+    float t_max_loc = ObjectSpaceDistance(r, t_max);
+    AnyPacketTest any_packet(triangle_packets, r_loc);
+    if(!triangle_wide_bvh.nodes.empty())
+    {
+        triangle_wide_bvh.Traverse(r_loc, t_max_loc, any_packet);
+    }
+    else
     {
-        t->SetMaterial(m);
+        triangle_bvh.Traverse(r_loc, t_max_loc, any_packet);
     }
+    return any_packet.hit;
 }
 
 
@@ -215,30 +173,178 @@ glm::vec2 Mesh::GetUVCoordinates(const glm::vec3 &point)
 }
 
 
-glm::vec2 Triangle::GetUVCoordinates(const glm::vec3 &point)
+bool Mesh::LoadCachedVertices()
+{
+    MeshCacheReader reader(cache_path, obj_hash);
+    if(!reader.IsValid())
+    {
+        return false;
+    }
+    const MeshCacheHeader &header = reader.Header();
+    reader.Read(vertex_positions, header.vertex_count);
+    reader.Read(vertex_normals, header.vertex_count);
+    reader.Read(vertex_uvs, header.vertex_count);
+    reader.Read(vertex_indices, header.index_count);
+    return true;
+}
+
+bool Mesh::LoadCachedBVH(const BVHBuildOptions &options)
 {
-    float A = Area(points[0], points[1], points[2]);
-    float A0 = Area(points[1], points[2], point);
-    float A1 = Area(points[0], points[2], point);
-    float A2 = Area(points[0], points[1], point);
-    return uvs[0] * A0/A + uvs[1] * A1/A + uvs[2] * A2/A;
+    MeshCacheReader reader(cache_path, obj_hash);
+    if(!reader.IsValid() || !reader.Header().SameBVHOptions(options)
+            || reader.Header().index_count != vertex_indices.size())
+    {
+        return false;
+    }
+    const MeshCacheHeader &header = reader.Header();
+    reader.Skip<glm::vec3>(header.vertex_count);
+    reader.Skip<glm::vec3>(header.vertex_count);
+    reader.Skip<glm::vec2>(header.vertex_count);
+    reader.Skip<unsigned int>(header.index_count);
+    triangle_bvh.Clear();
+    reader.Read(triangle_bvh.nodes, header.node_count);
+    reader.Read(triangle_packets, header.packet_count);
+    return true;
 }
 
+void Mesh::SaveCache(const BVHBuildOptions &options)
+{
+    if(obj_hash.isEmpty())
+    {
+        return;
+    }
+    MeshCacheHeader header;
+    memcpy(header.obj_hash, obj_hash.constData(), sizeof(header.obj_hash));
+    header.SetBVHOptions(options);
+    header.vertex_count = vertex_positions.size();
+    header.index_count = vertex_indices.size();
+    header.node_count = triangle_bvh.nodes.size();
+    header.packet_count = triangle_packets.size();
+
+    //Written to a temporary file that only replaces the old cache once it is complete.
+    QSaveFile file(cache_path);
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        std::cout << "Could not write mesh cache " << cache_path.toStdString() << std::endl;
+        return;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(MeshCacheHeader));
+    WriteMeshCacheArray(file, vertex_positions);
+    WriteMeshCacheArray(file, vertex_normals);
+    WriteMeshCacheArray(file, vertex_uvs);
+    WriteMeshCacheArray(file, vertex_indices);
+    WriteMeshCacheArray(file, triangle_bvh.nodes);
+    WriteMeshCacheArray(file, triangle_packets);
+    if(!file.commit())
+    {
+        std::cout << "Could not write mesh cache " << cache_path.toStdString() << std::endl;
+    }
+}
+
+//Builds the triangle BVH over the faces and copies each leaf's faces into a packet.
+void Mesh::BuildTriangleBVH(const BVHBuildOptions &options)
+{
+    int face_count = vertex_indices.size() / 3;
+    std::vector<BVHPrimitive> build_primitives(face_count);
+
+    for(int face = 0; face < face_count; face++){
+        BVHPrimitive &primitive = build_primitives[face];
+        primitive.minimum = glm::min(glm::min(FacePoint(face, 0), FacePoint(face, 1)), FacePoint(face, 2));
+        primitive.maximum = glm::max(glm::max(FacePoint(face, 0), FacePoint(face, 1)), FacePoint(face, 2));
+        primitive.center = primitive.minimum + (primitive.maximum - primitive.minimum)/ 2.0f;
+        primitive.index = face;
+    }
+    //Rebuild from the same input at several thread counts to measure how the build scales.
+    double single_thread_seconds = 0;
+    for(int threads = 1; options.benchmark && threads <= 16; threads *= 2){
+        std::vector<BVHPrimitive> benchmark_primitives = build_primitives;
+        BVHBuildOptions benchmark_options = options;
+        benchmark_options.thread_count = threads;
+        std::chrono::high_resolution_clock::time_point benchmark_start = std::chrono::high_resolution_clock::now();
+        triangle_bvh.Build(benchmark_primitives, benchmark_options);
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - benchmark_start).count();
+        if(threads == 1){
+            single_thread_seconds = seconds;
+        }
+        std::cout << "  " << threads << " threads: " << seconds << " s, speedup "
+                  << single_thread_seconds / seconds << std::endl;
+    }
+
+    std::chrono::high_resolution_clock::time_point build_start = std::chrono::high_resolution_clock::now();
+    triangle_bvh.Build(build_primitives, options);
+    double build_seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - build_start).count();
+
+    triangle_packets.clear();
+    for(LinearBVHNode &node : triangle_bvh.nodes){
+        if(node.primitive_count == 0){
+            continue;
+        }
+        TrianglePacket packet;
+        for(int lane = 0; lane < node.primitive_count; lane++){
+            int face = build_primitives[node.offset + lane].index;
+            packet.SetTriangle(lane, face, FacePoint(face, 0), FacePoint(face, 1), FacePoint(face, 2));
+        }
+        node.offset = triangle_packets.size();
+        triangle_packets.push_back(packet);
+    }
+    std::cout << "Mesh BVH over " << face_count << " triangles in " << triangle_packets.size()
+              << " packets built in " << build_seconds << " s, SAH cost " << triangle_bvh.SAHCost(options)
+              << ", " << TrianglePacketKernelName(GetTrianglePacketKernel()) << " kernel" << std::endl;
+
+}
 
-bvhNode *Mesh::SetBoundingBox() {
-    std::vector<bvhNode*> leaves;
-    foreach (Triangle *face, faces) {
-        face->transform = transform;
-        leaves.push_back(face->SetBoundingBox());
+bvhNode *Mesh::SetBoundingBox(const BVHBuildOptions &options) {
+    //Bottom level: an object space BVH over the faces. Each leaf holds up to TRIANGLE_PACKET_WIDTH
+    //faces, which are copied into a packet so the whole leaf is tested at once.
+    int face_count = vertex_indices.size() / 3;
+    //A packet costs about as much to test as a single triangle, so the SAH is given the cost per lane.
+    BVHBuildOptions packet_options = options;
+    packet_options.max_leaf_size = TRIANGLE_PACKET_WIDTH;
+    packet_options.intersection_cost = options.intersection_cost / TRIANGLE_PACKET_WIDTH;
+    //A benchmark has to build the tree, so it skips the cache.
+    if(!options.benchmark && LoadCachedBVH(packet_options))
+    {
+        std::cout << "Mesh BVH over " << face_count << " triangles in " << triangle_packets.size()
+                  << " packets loaded from " << cache_path.toStdString() << std::endl;
+    }
+    else
+    {
+        BuildTriangleBVH(packet_options);
+        SaveCache(packet_options);
+    }
+    //Nearly all of a mesh scene's nodes are in the triangle BVHs, so they are widened along with the
+    //scene's tree. The leaves keep their packet offsets.
+    if(options.branching_factor > 2)
+    {
+        triangle_wide_bvh.Collapse(triangle_bvh, options.branching_factor);
+    }
+    else
+    {
+        triangle_wide_bvh.Clear();
     }
-    bvh = bvhNode::CreateTree(leaves, 0, 0, leaves.size()-1);
 
+    //Top level: the mesh instance is a single leaf bounded by its transformed object space box.
     bvhNode *node = new bvhNode();
-    node->bounding_box = bvh->bounding_box;
-    node->left = bvh->left;
-    node->right = bvh->right;
     bounding_box = &(node->bounding_box);
+    glm::vec3 corners[2] = {glm::vec3(0), glm::vec3(0)};
+    if(!triangle_bvh.nodes.empty()){
+        corners[0] = triangle_bvh.nodes[0].minimum;
+        corners[1] = triangle_bvh.nodes[0].maximum;
+    }
+    glm::vec3 world_min(std::numeric_limits<float>::infinity());
+    glm::vec3 world_max(-std::numeric_limits<float>::infinity());
+    for(int i = 0; i < 8; i++){
+        glm::vec3 corner(corners[i & 1].x, corners[(i >> 1) & 1].y, corners[(i >> 2) & 1].z);
+        glm::vec3 world_corner = glm::vec3(transform.T() * glm::vec4(corner, 1.0f));
+        world_min = glm::min(world_min, world_corner);
+        world_max = glm::max(world_max, world_corner);
+    }
+    bounding_box->minimum = world_min;
+    bounding_box->maximum = world_max;
+    bounding_box->center = world_min + (world_max - world_min)/ 2.0f;
     bounding_box->object = this;
+    bounding_box->SetNormals();
+    bounding_box->create();
 
     return node;
 }
@@ -247,44 +353,59 @@ bvhNode *Mesh::SetBoundingBox() {
 void Mesh::LoadOBJ(const QStringRef &filename, const QStringRef &local_path)
 {
     QString filepath = local_path.toString(); filepath.append(filename);
+    cache_path = MeshCachePath(filepath);
+    obj_hash = HashMeshFile(filepath);
+    if(LoadCachedVertices())
+    {
+        std::cout << "Loaded " << vertex_indices.size() / 3 << " triangles from " << cache_path.toStdString() << std::endl;
+        return;
+    }
     std::vector<tinyobj::shape_t> shapes; std::vector<tinyobj::material_t> materials;
     std::string errors = tinyobj::LoadObj(shapes, materials, filepath.toStdString().c_str());
     std::cout << errors << std::endl;
     if(errors.size() == 0)
     {
-        //Read the information from the vector of shape_ts
+        //Append the information from the vector of shape_ts to the packed vertex buffers
         for(unsigned int i = 0; i < shapes.size(); i++)
         {
             std::vector<float> &positions = shapes[i].mesh.positions;
             std::vector<float> &normals = shapes[i].mesh.normals;
             std::vector<float> &uvs = shapes[i].mesh.texcoords;
             std::vector<unsigned int> &indices = shapes[i].mesh.indices;
-            for(unsigned int j = 0; j < indices.size(); j += 3)
+            if(normals.size() > 0)
             {
-                glm::vec3 p1(positions[indices[j]*3], positions[indices[j]*3+1], positions[indices[j]*3+2]);
-                glm::vec3 p2(positions[indices[j+1]*3], positions[indices[j+1]*3+1], positions[indices[j+1]*3+2]);
-                glm::vec3 p3(positions[indices[j+2]*3], positions[indices[j+2]*3+1], positions[indices[j+2]*3+2]);
-
-                Triangle* t = new Triangle(p1, p2, p3);
-                if(normals.size() > 0)
+                //Vertices with normals are shared between the faces that index them
+                unsigned int base = vertex_positions.size();
+                for(unsigned int j = 0; j < positions.size() / 3; j++)
+                {
+                    vertex_positions.push_back(glm::vec3(positions[j*3], positions[j*3+1], positions[j*3+2]));
+                    vertex_normals.push_back(glm::vec3(normals[j*3], normals[j*3+1], normals[j*3+2]));
+                    vertex_uvs.push_back(uvs.size() > 0 ? glm::vec2(uvs[j*2], uvs[j*2+1]) : glm::vec2(0));
+                }
+                for(unsigned int j = 0; j < indices.size(); j++)
                 {
-                    glm::vec3 n1(normals[indices[j]*3], normals[indices[j]*3+1], normals[indices[j]*3+2]);
-                    glm::vec3 n2(normals[indices[j+1]*3], normals[indices[j+1]*3+1], normals[indices[j+1]*3+2]);
-                    glm::vec3 n3(normals[indices[j+2]*3], normals[indices[j+2]*3+1], normals[indices[j+2]*3+2]);
-                    t->normals[0] = n1;
-                    t->normals[1] = n2;
-                    t->normals[2] = n3;
+                    vertex_indices.push_back(base + indices[j]);
                 }
-                if(uvs.size() > 0)
+            }
+            else
+            {
+                //Without normals every face gets its own vertices carrying the flat face normal
+                for(unsigned int j = 0; j < indices.size(); j += 3)
                 {
-                    glm::vec2 t1(uvs[indices[j]*2], uvs[indices[j]*2+1]);
-                    glm::vec2 t2(uvs[indices[j+1]*2], uvs[indices[j+1]*2+1]);
-                    glm::vec2 t3(uvs[indices[j+2]*2], uvs[indices[j+2]*2+1]);
-                    t->uvs[0] = t1;
-                    t->uvs[1] = t2;
-                    t->uvs[2] = t3;
+                    glm::vec3 p[3];
+                    for(int k = 0; k < 3; k++)
+                    {
+                        p[k] = glm::vec3(positions[indices[j+k]*3], positions[indices[j+k]*3+1], positions[indices[j+k]*3+2]);
+                    }
+                    glm::vec3 plane_normal = glm::normalize(glm::cross(p[1] - p[0], p[2] - p[1]));
+                    for(int k = 0; k < 3; k++)
+                    {
+                        vertex_indices.push_back(vertex_positions.size());
+                        vertex_positions.push_back(p[k]);
+                        vertex_normals.push_back(plane_normal);
+                        vertex_uvs.push_back(uvs.size() > 0 ? glm::vec2(uvs[indices[j+k]*2], uvs[indices[j+k]*2+1]) : glm::vec2(0));
+                    }
                 }
-                this->faces.append(t);
             }
         }
         std::cout << "" << std::endl;
@@ -298,45 +419,33 @@ void Mesh::LoadOBJ(const QStringRef &filename, const QStringRef &local_path)
 }
 
 void Mesh::create(){
-    //Count the number of vertices for each face so we can get a count for the entire mesh
-        std::vector<glm::vec3> vert_pos;
-        std::vector<glm::vec3> vert_nor;
-        std::vector<glm::vec3> vert_col;
-        std::vector<GLuint> vert_idx;
-
-        unsigned int index = 0;
-
-        for(int i = 0; i < faces.size(); i++){
-            Triangle* tri = faces[i];
-            vert_pos.push_back(tri->points[0]); vert_nor.push_back(tri->normals[0]); vert_col.push_back(tri->material->base_color);
-            vert_pos.push_back(tri->points[1]); vert_nor.push_back(tri->normals[1]); vert_col.push_back(tri->material->base_color);
-            vert_pos.push_back(tri->points[2]); vert_nor.push_back(tri->normals[2]); vert_col.push_back(tri->material->base_color);
-            vert_idx.push_back(index++);vert_idx.push_back(index++);vert_idx.push_back(index++);
-        }
-
-        count = vert_idx.size();
-        int vert_count = vert_pos.size();
-
-        bufIdx.create();
-        bufIdx.bind();
-        bufIdx.setUsagePattern(QOpenGLBuffer::StaticDraw);
-        bufIdx.allocate(vert_idx.data(), count * sizeof(GLuint));
-
-        bufPos.create();
-        bufPos.bind();
-        bufPos.setUsagePattern(QOpenGLBuffer::StaticDraw);
-        bufPos.allocate(vert_pos.data(), vert_count * sizeof(glm::vec3));
-
-        bufCol.create();
-        bufCol.bind();
-        bufCol.setUsagePattern(QOpenGLBuffer::StaticDraw);
-        bufCol.allocate(vert_col.data(), vert_count * sizeof(glm::vec3));
-
-        bufNor.create();
-        bufNor.bind();
-        bufNor.setUsagePattern(QOpenGLBuffer::StaticDraw);
-        bufNor.allocate(vert_nor.data(), vert_count * sizeof(glm::vec3));
+    if(!glEnabled())
+    {
+        return;
+    }
+    //The packed vertex buffers are uploaded as they are; only the colors are expanded per vertex
+    std::vector<glm::vec3> vert_col(vertex_positions.size(), material->base_color);
+
+    count = vertex_indices.size();
+    int vert_count = vertex_positions.size();
+
+    bufIdx.create();
+    bufIdx.bind();
+    bufIdx.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    bufIdx.allocate(vertex_indices.data(), count * sizeof(GLuint));
+
+    bufPos.create();
+    bufPos.bind();
+    bufPos.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    bufPos.allocate(vertex_positions.data(), vert_count * sizeof(glm::vec3));
+
+    bufCol.create();
+    bufCol.bind();
+    bufCol.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    bufCol.allocate(vert_col.data(), vert_count * sizeof(glm::vec3));
+
+    bufNor.create();
+    bufNor.bind();
+    bufNor.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    bufNor.allocate(vertex_normals.data(), vert_count * sizeof(glm::vec3));
 }
-
-//This does nothing because individual triangles are not rendered with OpenGL; they are rendered all together in their Mesh.
-void Triangle::create(){}
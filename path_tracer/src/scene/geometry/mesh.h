@@ -1,46 +1,19 @@
 #pragma once
 #include <scene/geometry/geometry.h>
+#include <scene/geometry/linearbvh.h>
+#include <scene/geometry/widebvh.h>
+#include <scene/geometry/trianglepacket.h>
+#include <scene/geometry/meshcache.h>
 #include <openGL/drawable.h>
-#include <QList>
+#include <vector>
 
-class Triangle : public Geometry
-{
-public:
-    Triangle(const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3);
-    Triangle(const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3, const glm::vec3 &n1, const glm::vec3 &n2, const glm::vec3 &n3);
-    Triangle(const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3, const glm::vec3 &n1, const glm::vec3 &n2, const glm::vec3 &n3, const glm::vec2 &t1, const glm::vec2 &t2, const glm::vec2 &t3);
-    Intersection GetIntersection(Ray r, Camera &camera);
-    virtual glm::vec2 GetUVCoordinates(const glm::vec3 &point);
-    virtual glm::vec3 ComputeNormal(const glm::vec3 &P);
-    virtual void ComputeTangents(const glm::vec3 &normal, glm::vec3 &tangent, glm::vec3 &bitangent);
-    virtual Intersection SampleLight(const IntersectionEngine *intersection_engine,
-                                     const glm::vec3 &origin, const float rand1, const float rand2,
-                                     const glm::vec3 &normal);
-    virtual glm::vec3 SampleArea(const float rand1, const float rand2, const glm::vec3 &normal, bool inWorldSpace);
-    bvhNode *SetBoundingBox();
-
-    virtual void ComputeArea();
-
-    glm::vec3 points[3];
-    glm::vec3 normals[3];
-    glm::vec2 uvs[3];
-    glm::vec3 plane_normal;
-
-    void create();//This does nothing because individual triangles are not rendered with OpenGL;
-                            //they are rendered all together in their Mesh.
-
-    glm::vec3 GetNormal(const glm::vec3 &position);//Returns the interpolation of the triangle's three normals
-                                                    //based on the point inside the triangle that is given.
-    glm::vec4 GetNormal(const glm::vec4 &position);
-};
-
-//A mesh just holds a collection of triangles against which one can test intersections.
-//Its primary purpose is to store VBOs for rendering the triangles in OpenGL.
+//A mesh holds a collection of triangles in packed vertex buffers against which one can test intersections.
+//The same buffers back the VBOs used for rendering the triangles in OpenGL.
 class Mesh : public Geometry
 {
 public:
-    Intersection GetIntersection(Ray r, Camera &camera);
-    void SetMaterial(Material *m);
+    Intersection GetIntersection(Ray r);
+    bool IntersectsBefore(Ray r, float t_max);
     void create();
     void LoadOBJ(const QStringRef &filename, const QStringRef &local_path);
     virtual glm::vec2 GetUVCoordinates(const glm::vec3 &point);
@@ -50,10 +23,30 @@ public:
                                      const glm::vec3 &origin, const float rand1, const float rand2,
                                      const glm::vec3 &normal);
     virtual glm::vec3 SampleArea(const float rand1, const float rand2, const glm::vec3 &normal, bool inWorldSpace);
-    bvhNode *SetBoundingBox();
+    bvhNode *SetBoundingBox(const BVHBuildOptions &options);
     virtual void ComputeArea();
 
 private:
-    QList<Triangle*> faces;
-    bvhNode *bvh;
+    glm::vec3 FacePoint(int face, int corner) const;
+    void FaceTangents(int face, glm::vec3 &tangent, glm::vec3 &bitangent) const;
+    //Computes the surface attributes of a hit on the given face, in object space.
+    Intersection GetSurfaceIntersection(const Ray &r_loc, int face, float t, float u, float v);
+    //Fill the vertex buffers, or the BVH and its packets, from the mesh cache if it is up to date.
+    bool LoadCachedVertices();
+    bool LoadCachedBVH(const BVHBuildOptions &options);
+    void SaveCache(const BVHBuildOptions &options);
+    void BuildTriangleBVH(const BVHBuildOptions &options);
+
+    //Packed, indexed vertex data. Every three entries of vertex_indices form one face.
+    std::vector<glm::vec3> vertex_positions;
+    std::vector<glm::vec3> vertex_normals;
+    std::vector<glm::vec2> vertex_uvs;
+    std::vector<unsigned int> vertex_indices;
+
+    LinearBVH triangle_bvh;                         //Object space BVH over the faces
+    std::vector<TrianglePacket> triangle_packets;   //Each leaf of triangle_bvh tests triangle_packets[leaf.offset]
+    WideBVH triangle_wide_bvh;                      //triangle_bvh collapsed for a branching factor above 2, else empty
+
+    QString cache_path;                             //Mesh cache next to the OBJ file
+    QByteArray obj_hash;                            //Content hash of the OBJ file, empty if it couldn't be read
 };
@@ -0,0 +1,98 @@
+#include <scene/geometry/meshcache.h>
+#include <scene/geometry/linearbvh.h>
+#include <scene/geometry/trianglepacket.h>
+#include <QCryptographicHash>
+#include <cstring>
+
+MeshCacheHeader::MeshCacheHeader()
+{
+    memset(this, 0, sizeof(MeshCacheHeader));
+    memcpy(magic, "MBVH", 4);
+    version = MESH_CACHE_VERSION;
+    node_size = sizeof(LinearBVHNode);
+    packet_size = sizeof(TrianglePacket);
+}
+
+void MeshCacheHeader::SetBVHOptions(const BVHBuildOptions &options)
+{
+    split_method = options.split_method;
+    max_leaf_size = options.max_leaf_size;
+    bin_count = options.bin_count;
+    traversal_cost = options.traversal_cost;
+    intersection_cost = options.intersection_cost;
+}
+
+//The thread count and branching factor are left out since they don't change the mesh's tree.
+bool MeshCacheHeader::SameBVHOptions(const BVHBuildOptions &options) const
+{
+    return split_method == options.split_method
+            && max_leaf_size == options.max_leaf_size
+            && bin_count == options.bin_count
+            && traversal_cost == options.traversal_cost
+            && intersection_cost == options.intersection_cost;
+}
+
+qint64 MeshCacheHeader::FileSize() const
+{
+    return sizeof(MeshCacheHeader)
+            + (qint64)vertex_count * (2 * sizeof(glm::vec3) + sizeof(glm::vec2))
+            + (qint64)index_count * sizeof(unsigned int)
+            + (qint64)node_count * node_size
+            + (qint64)packet_count * packet_size;
+}
+
+QByteArray HashMeshFile(const QString &path)
+{
+    QFile file(path);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (!file.open(QIODevice::ReadOnly) || !hash.addData(&file)) {
+        return QByteArray();
+    }
+    return hash.result();
+}
+
+QString MeshCachePath(const QString &obj_path)
+{
+    return obj_path + QString(".bvhcache");
+}
+
+MeshCacheReader::MeshCacheReader(const QString &path, const QByteArray &obj_hash) :
+    file(path), data(NULL), position(sizeof(MeshCacheHeader))
+{
+    if (obj_hash.size() != sizeof(header.obj_hash) || !file.open(QIODevice::ReadOnly)
+            || file.size() < (qint64)sizeof(MeshCacheHeader)) {
+        return;
+    }
+    data = file.map(0, file.size());
+    if (data == NULL) {
+        return;
+    }
+    MeshCacheHeader expected;
+    memcpy(&header, data, sizeof(MeshCacheHeader));
+    if (memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0
+            || header.version != expected.version
+            || header.node_size != expected.node_size
+            || header.packet_size != expected.packet_size
+            || memcmp(header.obj_hash, obj_hash.constData(), sizeof(header.obj_hash)) != 0
+            || header.FileSize() != file.size()) {
+        file.unmap(data);
+        data = NULL;
+    }
+}
+
+MeshCacheReader::~MeshCacheReader()
+{
+    if (data != NULL) {
+        file.unmap(data);
+    }
+}
+
+bool MeshCacheReader::IsValid() const
+{
+    return data != NULL;
+}
+
+const MeshCacheHeader &MeshCacheReader::Header() const
+{
+    return header;
+}
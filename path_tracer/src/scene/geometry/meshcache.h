@@ -0,0 +1,95 @@
+#pragma once
+
+#include <la.h>
+#include <scene/geometry/bvhbuildoptions.h>
+#include <QFile>
+#include <QByteArray>
+#include <QString>
+#include <vector>
+#include <cstdint>
+
+//A mesh cache is a binary file written next to an OBJ file. It holds the mesh's packed vertex
+//buffers, its flattened triangle BVH and the BVH's triangle packets, so that a warm start skips
+//both parsing and building. The vertex buffers are used whenever the OBJ file's content hash
+//matches; the BVH only when it was also built with the same options. Arrays are stored in the
+//memory layout of the machine that wrote the file, in this order: positions, normals, uvs,
+//indices, nodes, packets.
+
+#define MESH_CACHE_VERSION 1
+
+struct MeshCacheHeader {
+    MeshCacheHeader();
+    void SetBVHOptions(const BVHBuildOptions &options);
+    bool SameBVHOptions(const BVHBuildOptions &options) const;
+    //Size of the whole file the counts describe.
+    qint64 FileSize() const;
+
+    char magic[4];
+    uint32_t version;
+    uint32_t node_size;             //sizeof(LinearBVHNode) when written
+    uint32_t packet_size;           //sizeof(TrianglePacket) when written
+    char obj_hash[20];              //SHA-1 of the OBJ file
+
+    int32_t split_method;
+    int32_t max_leaf_size;
+    int32_t bin_count;
+    float traversal_cost;
+    float intersection_cost;
+
+    uint32_t vertex_count;
+    uint32_t index_count;
+    uint32_t node_count;
+    uint32_t packet_count;
+};
+
+//Returns the SHA-1 of the file's contents, or an empty array if it cannot be read.
+QByteArray HashMeshFile(const QString &path);
+QString MeshCachePath(const QString &obj_path);
+
+//Memory maps a cache file and reads its arrays in order. The reader is only valid if the file
+//is complete and was written for an OBJ file with the given hash.
+//This is not a zero-copy load: every array is copied out of the mapping into the mesh's own
+//vectors, and the mapping is released with the reader. The map only saves the pages of sections
+//that are skipped, such as a BVH built with other options, from being read at all.
+class MeshCacheReader
+{
+public:
+    MeshCacheReader(const QString &path, const QByteArray &obj_hash);
+    ~MeshCacheReader();
+    bool IsValid() const;
+    const MeshCacheHeader &Header() const;
+
+    //Copies the next count elements of the file into out, which does not refer to the file afterwards.
+    template <typename T>
+    void Read(std::vector<T> &out, uint32_t count);
+    template <typename T>
+    void Skip(uint32_t count);
+
+private:
+    QFile file;
+    uchar *data;
+    qint64 position;
+    MeshCacheHeader header;
+};
+
+template <typename T>
+void MeshCacheReader::Read(std::vector<T> &out, uint32_t count)
+{
+    const T *first = reinterpret_cast<const T*>(data + position);
+    out.assign(first, first + count);
+    position += (qint64)count * sizeof(T);
+}
+
+template <typename T>
+void MeshCacheReader::Skip(uint32_t count)
+{
+    position += (qint64)count * sizeof(T);
+}
+
+template <typename T>
+void WriteMeshCacheArray(QIODevice &device, const std::vector<T> &array)
+{
+    if (!array.empty()) {
+        device.write(reinterpret_cast<const char*>(array.data()), (qint64)array.size() * sizeof(T));
+    }
+}
@@ -4,6 +4,7 @@
 
 #include <la.h>
 #include <math.h>
+#include <helpers.h>
 
 static const int SPH_IDX_COUNT = 2280;  // 760 tris * 3
 static const int SPH_VERT_COUNT = 382;
@@ -50,8 +51,13 @@ Intersection Sphere::SampleLight(const IntersectionEngine *intersection_engine,
 
         glm::vec3 world_point = glm::vec3(transform.T() * pointL);
         Ray ray_to_light(origin, world_point-origin);
-        Intersection result = intersection_engine->GetIntersection(ray_to_light);
-
+        //Intersect the light alone, then check that nothing opaque blocks the path to it.
+        Intersection result = GetIntersection(ray_to_light);
+        if(result.object_hit == NULL
+                || intersection_engine->Occluded(ray_to_light, result.t - OFFSET))
+        {
+            return Intersection();
+        }
         return result;
 }
 
@@ -90,7 +96,7 @@ float Sphere::RayPDF(const Intersection &isx, const Ray &ray, const Intersection
 }
 
 
-Intersection Sphere::GetIntersection(Ray r, Camera &camera)
+Intersection Sphere::GetIntersection(Ray r)
 {
     //Transform the ray
     Ray r_loc = r.GetTransformedCopy(transform.invT());
@@ -132,6 +138,25 @@ Intersection Sphere::GetIntersection(Ray r, Camera &camera)
 }
 
 
+bool Sphere::IntersectsBefore(Ray r, float t_max)
+{
+    Ray r_loc = r.GetTransformedCopy(transform.invT());
+    float A = glm::dot(r_loc.direction, r_loc.direction);
+    float B = 2 * glm::dot(r_loc.direction, r_loc.origin);
+    float C = glm::dot(r_loc.origin, r_loc.origin) - 0.25f;//Radius is 0.5f
+    float discriminant = B*B - 4*A*C;
+    if(discriminant < 0){
+        return false;
+    }
+    float t = (-B - sqrt(discriminant))/(2*A);
+    if(t < 0)
+    {
+        t = (-B + sqrt(discriminant))/(2*A);
+    }
+    return t >= 0 && t < ObjectSpaceDistance(r, t_max);
+}
+
+
 void Sphere::ComputeTangents(const glm::vec3 &normal,
                      glm::vec3 &tangent, glm::vec3 &bitangent)
 {
@@ -242,7 +267,7 @@ void createSphereIndices(GLuint (&sph_idx)[SPH_IDX_COUNT])
     index += 3;
 }
 
-bvhNode *Sphere::SetBoundingBox() {
+bvhNode *Sphere::SetBoundingBox(const BVHBuildOptions &) {
     bvhNode *node = new bvhNode();
 
    glm::vec3 vertex0 = glm::vec3(transform.T() * glm::vec4(-0.5f, -0.5f, -0.5f, 1.0f));
@@ -282,6 +307,10 @@ bvhNode *Sphere::SetBoundingBox() {
 
 void Sphere::create()
 {
+    if(!glEnabled())
+    {
+        return;
+    }
     GLuint sph_idx[SPH_IDX_COUNT];
     glm::vec3 sph_vert_pos[SPH_VERT_COUNT];
     glm::vec3 sph_vert_nor[SPH_VERT_COUNT];
@@ -1,4 +1,5 @@
 #include <scene/geometry/square.h>
+#include <helpers.h>
 
 void SquarePlane::ComputeArea()
 {
@@ -9,7 +10,7 @@ void SquarePlane::ComputeArea()
 }
 
 
-Intersection SquarePlane::GetIntersection(Ray r, Camera &camera)
+Intersection SquarePlane::GetIntersection(Ray r)
 {
     //Transform the ray
     Ray r_loc = r.GetTransformedCopy(transform.invT());
@@ -39,6 +40,16 @@ Intersection SquarePlane::GetIntersection(Ray r, Camera &camera)
 }
 
 
+bool SquarePlane::IntersectsBefore(Ray r, float t_max)
+{
+    Ray r_loc = r.GetTransformedCopy(transform.invT());
+    float t = glm::dot(glm::vec3(0,0,1), (glm::vec3(0.5f, 0.5f, 0) - r_loc.origin)) / glm::dot(glm::vec3(0,0,1), r_loc.direction);
+    glm::vec3 P = t * r_loc.direction + r_loc.origin;
+    return t > 0 && P.x >= -0.5f && P.x <= 0.5f && P.y >= -0.5f && P.y <= 0.5f
+            && t < ObjectSpaceDistance(r, t_max);
+}
+
+
 glm::vec2 SquarePlane::GetUVCoordinates(const glm::vec3 &point)
 {
     return glm::vec2(point.x + 0.5f, point.y + 0.5f);
@@ -62,7 +73,13 @@ Intersection SquarePlane::SampleLight(
     glm::vec3 world_point = SampleArea(rand1, rand2, normal, true);
     Ray r(origin, world_point - origin);
 
-    Intersection result = intersection_engine->GetIntersection(r);
+    //Intersect the light alone, then check that nothing opaque blocks the path to it.
+    Intersection result = GetIntersection(r);
+    if(result.object_hit == NULL
+            || intersection_engine->Occluded(r, result.t - OFFSET))
+    {
+        return Intersection();
+    }
     return result;
 }
 
@@ -89,7 +106,7 @@ void SquarePlane::ComputeTangents(const glm::vec3 &normal,
 
 
 // Set min and max bounds for a bounding box.
-bvhNode *SquarePlane::SetBoundingBox() {
+bvhNode *SquarePlane::SetBoundingBox(const BVHBuildOptions &) {
     bvhNode *node = new bvhNode();
 
     glm::vec3 vertex0 = glm::vec3(transform.T() * glm::vec4(-0.5f, -0.5f, 0.0f, 1.0f));
@@ -119,6 +136,10 @@ bvhNode *SquarePlane::SetBoundingBox() {
 
 void SquarePlane::create()
 {
+    if(!glEnabled())
+    {
+        return;
+    }
     GLuint cub_idx[6];
     glm::vec3 cub_vert_pos[4];
     glm::vec3 cub_vert_nor[4];
@@ -0,0 +1,350 @@
+#include <scene/geometry/trianglepacket.h>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRIANGLE_PACKET_SSE
+#include <emmintrin.h>
+#endif
+
+//AVX2 code is compiled per function with the target attribute and only run after a CPU check,
+//so the rest of the program keeps its baseline instruction set.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define TRIANGLE_PACKET_AVX2
+#include <immintrin.h>
+#endif
+
+TrianglePacket::TrianglePacket()
+{
+    for (int i=0; i < TRIANGLE_PACKET_WIDTH; i++) {
+        for (int axis=0; axis < 3; axis++) {
+            p0[axis][i] = 0.0f;
+            edge1[axis][i] = 0.0f;
+            edge2[axis][i] = 0.0f;
+        }
+        face[i] = -1;
+    }
+}
+
+void TrianglePacket::SetTriangle(int lane, int face_index, const glm::vec3 &v0, const glm::vec3 &v1, const glm::vec3 &v2)
+{
+    glm::vec3 e1 = v1 - v0;
+    glm::vec3 e2 = v2 - v0;
+    for (int axis=0; axis < 3; axis++) {
+        p0[axis][lane] = v0[axis];
+        edge1[axis][lane] = e1[axis];
+        edge2[axis][lane] = e2[axis];
+    }
+    face[lane] = face_index;
+}
+
+// The kernels below all evaluate the same expressions in the same order, so they agree bit for bit.
+
+static inline bool IntersectLane(const TrianglePacket &packet, int i, const glm::vec3 &o, const glm::vec3 &d,
+                                 float t_min, float t_max, float &t, float &u, float &v)
+{
+    float e1x = packet.edge1[0][i], e1y = packet.edge1[1][i], e1z = packet.edge1[2][i];
+    float e2x = packet.edge2[0][i], e2y = packet.edge2[1][i], e2z = packet.edge2[2][i];
+    // pvec = cross(direction, edge2)
+    float px = d.y * e2z - d.z * e2y;
+    float py = d.z * e2x - d.x * e2z;
+    float pz = d.x * e2y - d.y * e2x;
+    float det = e1x * px + e1y * py + e1z * pz;
+    float inv_det = 1.0f / det;
+    // tvec = origin - p0
+    float tx = o.x - packet.p0[0][i];
+    float ty = o.y - packet.p0[1][i];
+    float tz = o.z - packet.p0[2][i];
+    u = (tx * px + ty * py + tz * pz) * inv_det;
+    // qvec = cross(tvec, edge1)
+    float qx = ty * e1z - tz * e1y;
+    float qy = tz * e1x - tx * e1z;
+    float qz = tx * e1y - ty * e1x;
+    v = (d.x * qx + d.y * qy + d.z * qz) * inv_det;
+    t = (e2x * qx + e2y * qy + e2z * qz) * inv_det;
+    return det != 0.0f && u >= 0.0f && u <= 1.0f && v >= 0.0f && u + v <= 1.0f
+            && t > 0.0f && t >= t_min && t < t_max;
+}
+
+static int IntersectPacketScalar(const TrianglePacket &packet, const glm::vec3 &origin,
+                                 const glm::vec3 &direction, float t_min, float &t_max, float &u, float &v)
+{
+    int lane = -1;
+    for (int i=0; i < TRIANGLE_PACKET_WIDTH; i++) {
+        float t, lane_u, lane_v;
+        if (IntersectLane(packet, i, origin, direction, t_min, t_max, t, lane_u, lane_v)) {
+            lane = i;
+            t_max = t;
+            u = lane_u;
+            v = lane_v;
+        }
+    }
+    return lane;
+}
+
+static bool OccludedScalar(const TrianglePacket &packet, const glm::vec3 &origin,
+                           const glm::vec3 &direction, float t_max)
+{
+    for (int i=0; i < TRIANGLE_PACKET_WIDTH; i++) {
+        float t, u, v;
+        if (IntersectLane(packet, i, origin, direction, 0.0f, t_max, t, u, v)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#ifdef TRIANGLE_PACKET_SSE
+// Intersects lanes [first, first + 4). Returns the lane hit mask; t holds +inf in lanes that missed.
+static inline int IntersectQuadSSE(const TrianglePacket &packet, int first, const __m128 o[3], const __m128 d[3],
+                                   __m128 t_min, __m128 t_max, __m128 &t, __m128 &u, __m128 &v)
+{
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 e1x = _mm_loadu_ps(&packet.edge1[0][first]);
+    __m128 e1y = _mm_loadu_ps(&packet.edge1[1][first]);
+    __m128 e1z = _mm_loadu_ps(&packet.edge1[2][first]);
+    __m128 e2x = _mm_loadu_ps(&packet.edge2[0][first]);
+    __m128 e2y = _mm_loadu_ps(&packet.edge2[1][first]);
+    __m128 e2z = _mm_loadu_ps(&packet.edge2[2][first]);
+    __m128 px = _mm_sub_ps(_mm_mul_ps(d[1], e2z), _mm_mul_ps(d[2], e2y));
+    __m128 py = _mm_sub_ps(_mm_mul_ps(d[2], e2x), _mm_mul_ps(d[0], e2z));
+    __m128 pz = _mm_sub_ps(_mm_mul_ps(d[0], e2y), _mm_mul_ps(d[1], e2x));
+    __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+    __m128 inv_det = _mm_div_ps(one, det);
+    __m128 tx = _mm_sub_ps(o[0], _mm_loadu_ps(&packet.p0[0][first]));
+    __m128 ty = _mm_sub_ps(o[1], _mm_loadu_ps(&packet.p0[1][first]));
+    __m128 tz = _mm_sub_ps(o[2], _mm_loadu_ps(&packet.p0[2][first]));
+    u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), inv_det);
+    __m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+    __m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+    __m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+    v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(d[0], qx), _mm_mul_ps(d[1], qy)), _mm_mul_ps(d[2], qz)), inv_det);
+    __m128 lane_t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inv_det);
+
+    __m128 hit = _mm_cmpneq_ps(det, zero);
+    hit = _mm_and_ps(hit, _mm_cmpge_ps(u, zero));
+    hit = _mm_and_ps(hit, _mm_cmple_ps(u, one));
+    hit = _mm_and_ps(hit, _mm_cmpge_ps(v, zero));
+    hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), one));
+    hit = _mm_and_ps(hit, _mm_cmpgt_ps(lane_t, zero));
+    hit = _mm_and_ps(hit, _mm_cmpge_ps(lane_t, t_min));
+    hit = _mm_and_ps(hit, _mm_cmplt_ps(lane_t, t_max));
+    __m128 inf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    t = _mm_or_ps(_mm_and_ps(hit, lane_t), _mm_andnot_ps(hit, inf));
+    return _mm_movemask_ps(hit);
+}
+
+static int IntersectPacketSSE(const TrianglePacket &packet, const glm::vec3 &origin,
+                              const glm::vec3 &direction, float t_min, float &t_max, float &u, float &v)
+{
+    __m128 o[3] = {_mm_set1_ps(origin.x), _mm_set1_ps(origin.y), _mm_set1_ps(origin.z)};
+    __m128 d[3] = {_mm_set1_ps(direction.x), _mm_set1_ps(direction.y), _mm_set1_ps(direction.z)};
+    __m128 t_min4 = _mm_set1_ps(t_min);
+    __m128 t_max4 = _mm_set1_ps(t_max);
+    __m128 t[2], us[2], vs[2];
+    int hits = IntersectQuadSSE(packet, 0, o, d, t_min4, t_max4, t[0], us[0], vs[0])
+            | IntersectQuadSSE(packet, 4, o, d, t_min4, t_max4, t[1], us[1], vs[1]);
+    if (hits == 0) {
+        return -1;
+    }
+    // Horizontal minimum over all eight lanes.
+    __m128 m = _mm_min_ps(t[0], t[1]);
+    m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+    int closest = _mm_movemask_ps(_mm_cmpeq_ps(t[0], m)) | (_mm_movemask_ps(_mm_cmpeq_ps(t[1], m)) << 4);
+    int lane = 0;
+    while (!(closest & (1 << lane))) {
+        lane++;
+    }
+    float lane_t[8], lane_u[8], lane_v[8];
+    _mm_storeu_ps(lane_t, t[0]); _mm_storeu_ps(lane_t + 4, t[1]);
+    _mm_storeu_ps(lane_u, us[0]); _mm_storeu_ps(lane_u + 4, us[1]);
+    _mm_storeu_ps(lane_v, vs[0]); _mm_storeu_ps(lane_v + 4, vs[1]);
+    t_max = lane_t[lane];
+    u = lane_u[lane];
+    v = lane_v[lane];
+    return lane;
+}
+
+static bool OccludedSSE(const TrianglePacket &packet, const glm::vec3 &origin,
+                        const glm::vec3 &direction, float t_max)
+{
+    __m128 o[3] = {_mm_set1_ps(origin.x), _mm_set1_ps(origin.y), _mm_set1_ps(origin.z)};
+    __m128 d[3] = {_mm_set1_ps(direction.x), _mm_set1_ps(direction.y), _mm_set1_ps(direction.z)};
+    __m128 t_max4 = _mm_set1_ps(t_max);
+    __m128 t, u, v;
+    __m128 zero = _mm_setzero_ps();
+    return IntersectQuadSSE(packet, 0, o, d, zero, t_max4, t, u, v) != 0
+            || IntersectQuadSSE(packet, 4, o, d, zero, t_max4, t, u, v) != 0;
+}
+#endif
+
+#ifdef TRIANGLE_PACKET_AVX2
+// Intersects all eight lanes. Returns the lane hit mask; t holds +inf in lanes that missed.
+__attribute__((target("avx2")))
+static inline int IntersectOctAVX2(const TrianglePacket &packet, const glm::vec3 &origin, const glm::vec3 &direction,
+                                   float t_min, float t_max, __m256 &t, __m256 &u, __m256 &v)
+{
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 ox = _mm256_set1_ps(origin.x), oy = _mm256_set1_ps(origin.y), oz = _mm256_set1_ps(origin.z);
+    __m256 dx = _mm256_set1_ps(direction.x), dy = _mm256_set1_ps(direction.y), dz = _mm256_set1_ps(direction.z);
+    __m256 e1x = _mm256_loadu_ps(packet.edge1[0]);
+    __m256 e1y = _mm256_loadu_ps(packet.edge1[1]);
+    __m256 e1z = _mm256_loadu_ps(packet.edge1[2]);
+    __m256 e2x = _mm256_loadu_ps(packet.edge2[0]);
+    __m256 e2y = _mm256_loadu_ps(packet.edge2[1]);
+    __m256 e2z = _mm256_loadu_ps(packet.edge2[2]);
+    __m256 px = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y));
+    __m256 py = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z));
+    __m256 pz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x));
+    __m256 det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, px), _mm256_mul_ps(e1y, py)), _mm256_mul_ps(e1z, pz));
+    __m256 inv_det = _mm256_div_ps(one, det);
+    __m256 tx = _mm256_sub_ps(ox, _mm256_loadu_ps(packet.p0[0]));
+    __m256 ty = _mm256_sub_ps(oy, _mm256_loadu_ps(packet.p0[1]));
+    __m256 tz = _mm256_sub_ps(oz, _mm256_loadu_ps(packet.p0[2]));
+    u = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(tx, px), _mm256_mul_ps(ty, py)), _mm256_mul_ps(tz, pz)), inv_det);
+    __m256 qx = _mm256_sub_ps(_mm256_mul_ps(ty, e1z), _mm256_mul_ps(tz, e1y));
+    __m256 qy = _mm256_sub_ps(_mm256_mul_ps(tz, e1x), _mm256_mul_ps(tx, e1z));
+    __m256 qz = _mm256_sub_ps(_mm256_mul_ps(tx, e1y), _mm256_mul_ps(ty, e1x));
+    v = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, qx), _mm256_mul_ps(dy, qy)), _mm256_mul_ps(dz, qz)), inv_det);
+    __m256 lane_t = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)), _mm256_mul_ps(e2z, qz)), inv_det);
+
+    __m256 hit = _mm256_cmp_ps(det, zero, _CMP_NEQ_UQ);
+    hit = _mm256_and_ps(hit, _mm256_cmp_ps(u, zero, _CMP_GE_OQ));
+    hit = _mm256_and_ps(hit, _mm256_cmp_ps(u, one, _CMP_LE_OQ));
+    hit = _mm256_and_ps(hit, _mm256_cmp_ps(v, zero, _CMP_GE_OQ));
+    hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ));
+    hit = _mm256_and_ps(hit, _mm256_cmp_ps(lane_t, zero, _CMP_GT_OQ));
+    hit = _mm256_and_ps(hit, _mm256_cmp_ps(lane_t, _mm256_set1_ps(t_min), _CMP_GE_OQ));
+    hit = _mm256_and_ps(hit, _mm256_cmp_ps(lane_t, _mm256_set1_ps(t_max), _CMP_LT_OQ));
+    t = _mm256_blendv_ps(_mm256_set1_ps(std::numeric_limits<float>::infinity()), lane_t, hit);
+    return _mm256_movemask_ps(hit);
+}
+
+__attribute__((target("avx2")))
+static int IntersectPacketAVX2(const TrianglePacket &packet, const glm::vec3 &origin,
+                               const glm::vec3 &direction, float t_min, float &t_max, float &u, float &v)
+{
+    __m256 t, us, vs;
+    if (IntersectOctAVX2(packet, origin, direction, t_min, t_max, t, us, vs) == 0) {
+        return -1;
+    }
+    // Horizontal minimum over all eight lanes.
+    __m256 m = _mm256_min_ps(t, _mm256_permute2f128_ps(t, t, 1));
+    m = _mm256_min_ps(m, _mm256_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    m = _mm256_min_ps(m, _mm256_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+    int lane = __builtin_ctz(_mm256_movemask_ps(_mm256_cmp_ps(t, m, _CMP_EQ_OQ)));
+    float lane_t[8], lane_u[8], lane_v[8];
+    _mm256_storeu_ps(lane_t, t);
+    _mm256_storeu_ps(lane_u, us);
+    _mm256_storeu_ps(lane_v, vs);
+    t_max = lane_t[lane];
+    u = lane_u[lane];
+    v = lane_v[lane];
+    return lane;
+}
+
+__attribute__((target("avx2")))
+static bool OccludedAVX2(const TrianglePacket &packet, const glm::vec3 &origin,
+                         const glm::vec3 &direction, float t_max)
+{
+    __m256 t, u, v;
+    return IntersectOctAVX2(packet, origin, direction, 0.0f, t_max, t, u, v) != 0;
+}
+#endif
+
+static bool KernelSupported(TrianglePacketKernel kernel)
+{
+    switch (kernel) {
+    case PACKET_KERNEL_SCALAR:
+        return true;
+    case PACKET_KERNEL_SSE:
+#ifdef TRIANGLE_PACKET_SSE
+        return true;
+#else
+        return false;
+#endif
+    case PACKET_KERNEL_AVX2:
+#ifdef TRIANGLE_PACKET_AVX2
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+static TrianglePacketKernel BestKernel()
+{
+    if (KernelSupported(PACKET_KERNEL_AVX2)) {
+        return PACKET_KERNEL_AVX2;
+    }
+    if (KernelSupported(PACKET_KERNEL_SSE)) {
+        return PACKET_KERNEL_SSE;
+    }
+    return PACKET_KERNEL_SCALAR;
+}
+
+static TrianglePacketKernel active_kernel = BestKernel();
+
+int IntersectTrianglePacket(const TrianglePacket &packet, const glm::vec3 &origin,
+                            const glm::vec3 &direction, float t_min, float &t_max, float &u, float &v)
+{
+    switch (active_kernel) {
+#ifdef TRIANGLE_PACKET_AVX2
+    case PACKET_KERNEL_AVX2:
+        return IntersectPacketAVX2(packet, origin, direction, t_min, t_max, u, v);
+#endif
+#ifdef TRIANGLE_PACKET_SSE
+    case PACKET_KERNEL_SSE:
+        return IntersectPacketSSE(packet, origin, direction, t_min, t_max, u, v);
+#endif
+    default:
+        return IntersectPacketScalar(packet, origin, direction, t_min, t_max, u, v);
+    }
+}
+
+bool OccludedByTrianglePacket(const TrianglePacket &packet, const glm::vec3 &origin,
+                              const glm::vec3 &direction, float t_max)
+{
+    switch (active_kernel) {
+#ifdef TRIANGLE_PACKET_AVX2
+    case PACKET_KERNEL_AVX2:
+        return OccludedAVX2(packet, origin, direction, t_max);
+#endif
+#ifdef TRIANGLE_PACKET_SSE
+    case PACKET_KERNEL_SSE:
+        return OccludedSSE(packet, origin, direction, t_max);
+#endif
+    default:
+        return OccludedScalar(packet, origin, direction, t_max);
+    }
+}
+
+bool SetTrianglePacketKernel(TrianglePacketKernel kernel)
+{
+    if (!KernelSupported(kernel)) {
+        return false;
+    }
+    active_kernel = kernel;
+    return true;
+}
+
+TrianglePacketKernel GetTrianglePacketKernel()
+{
+    return active_kernel;
+}
+
+const char *TrianglePacketKernelName(TrianglePacketKernel kernel)
+{
+    switch (kernel) {
+    case PACKET_KERNEL_AVX2:
+        return "AVX2";
+    case PACKET_KERNEL_SSE:
+        return "SSE";
+    default:
+        return "scalar";
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <la.h>
+
+#define TRIANGLE_PACKET_WIDTH 8
+
+//Up to TRIANGLE_PACKET_WIDTH triangles in structure-of-arrays form, each stored as a vertex and
+//the two edges leaving it. Unused lanes have zero edges, which never produce a hit.
+struct TrianglePacket {
+    TrianglePacket();
+    void SetTriangle(int lane, int face_index, const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2);
+
+    float p0[3][TRIANGLE_PACKET_WIDTH];
+    float edge1[3][TRIANGLE_PACKET_WIDTH];
+    float edge2[3][TRIANGLE_PACKET_WIDTH];
+    int face[TRIANGLE_PACKET_WIDTH];        //Mesh face of each lane, -1 for unused lanes
+};
+
+//Instruction sets the packet kernels can run with. The fastest one the CPU supports is picked at startup.
+enum TrianglePacketKernel {
+    PACKET_KERNEL_SCALAR,
+    PACKET_KERNEL_SSE,
+    PACKET_KERNEL_AVX2
+};
+
+//Finds the closest Moller-Trumbore hit in the packet with t in (0, t_max) and t >= t_min. Returns the
+//lane that was hit, or -1, and on a hit shrinks t_max and writes the barycentric weights u and v of
+//the second and third vertices. Every kernel returns bit-identical results.
+int IntersectTrianglePacket(const TrianglePacket &packet, const glm::vec3 &origin,
+                            const glm::vec3 &direction, float t_min, float &t_max, float &u, float &v);
+//Returns true if any triangle in the packet is hit with t in (0, t_max).
+bool OccludedByTrianglePacket(const TrianglePacket &packet, const glm::vec3 &origin,
+                              const glm::vec3 &direction, float t_max);
+
+//Switches kernels, e.g. to compare against the scalar one. Returns false if the CPU lacks support.
+bool SetTrianglePacketKernel(TrianglePacketKernel kernel);
+TrianglePacketKernel GetTrianglePacketKernel();
+const char *TrianglePacketKernelName(TrianglePacketKernel kernel);
@@ -0,0 +1,208 @@
+#include <scene/geometry/widebvh.h>
+#include <scene/geometry/linearbvh.h>
+#include <scene/geometry/bvhsplit.h>
+#include <scene/geometry/bvhleaftests.h>
+#include <scene/geometry/trianglepacket.h>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WIDE_BVH_SSE
+#include <emmintrin.h>
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define WIDE_BVH_AVX2
+#include <immintrin.h>
+#endif
+
+WideBVHNode::WideBVHNode()
+{
+    for (int i=0; i < WIDE_BVH_MAX_WIDTH; i++) {
+        for (int axis=0; axis < 3; axis++) {
+            minimum[axis][i] = std::numeric_limits<float>::infinity();
+            maximum[axis][i] = -std::numeric_limits<float>::infinity();
+        }
+        offset[i] = -1;
+        primitive_count[i] = 0;
+    }
+}
+
+// The slab tests below keep the comparison order of IntersectBounds, so a NaN from a ray lying
+// in a slab plane leaves the interval unchanged in every kernel.
+
+static int IntersectNodeScalar(const WideBVHNode &node, const glm::vec3 &origin, const glm::vec3 &inv_dir,
+                               const int dir_is_neg[3], float t_max, float t_near[WIDE_BVH_MAX_WIDTH])
+{
+    int hits = 0;
+    for (int lane=0; lane < WIDE_BVH_MAX_WIDTH; lane++) {
+        float t0 = 0.0f;
+        float t1 = t_max;
+        for (int axis=0; axis < 3; axis++) {
+            const float *near_plane = dir_is_neg[axis] ? node.maximum[axis] : node.minimum[axis];
+            const float *far_plane = dir_is_neg[axis] ? node.minimum[axis] : node.maximum[axis];
+            float tn = (near_plane[lane] - origin[axis]) * inv_dir[axis];
+            float tf = (far_plane[lane] - origin[axis]) * inv_dir[axis];
+            t0 = tn > t0 ? tn : t0;
+            t1 = tf < t1 ? tf : t1;
+        }
+        t_near[lane] = t0;
+        if (t0 <= t1) {
+            hits |= 1 << lane;
+        }
+    }
+    return hits;
+}
+
+#ifdef WIDE_BVH_SSE
+static int IntersectNodeSSE(const WideBVHNode &node, const glm::vec3 &origin, const glm::vec3 &inv_dir,
+                            const int dir_is_neg[3], float t_max, float t_near[WIDE_BVH_MAX_WIDTH])
+{
+    int hits = 0;
+    for (int first=0; first < WIDE_BVH_MAX_WIDTH; first += 4) {
+        __m128 t0 = _mm_setzero_ps();
+        __m128 t1 = _mm_set1_ps(t_max);
+        for (int axis=0; axis < 3; axis++) {
+            const float *near_plane = dir_is_neg[axis] ? node.maximum[axis] : node.minimum[axis];
+            const float *far_plane = dir_is_neg[axis] ? node.minimum[axis] : node.maximum[axis];
+            __m128 o = _mm_set1_ps(origin[axis]);
+            __m128 inv = _mm_set1_ps(inv_dir[axis]);
+            __m128 tn = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(near_plane + first), o), inv);
+            __m128 tf = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(far_plane + first), o), inv);
+            t0 = _mm_max_ps(tn, t0);
+            t1 = _mm_min_ps(tf, t1);
+        }
+        _mm_storeu_ps(t_near + first, t0);
+        hits |= _mm_movemask_ps(_mm_cmple_ps(t0, t1)) << first;
+    }
+    return hits;
+}
+#endif
+
+#ifdef WIDE_BVH_AVX2
+__attribute__((target("avx2")))
+static int IntersectNodeAVX2(const WideBVHNode &node, const glm::vec3 &origin, const glm::vec3 &inv_dir,
+                             const int dir_is_neg[3], float t_max, float t_near[WIDE_BVH_MAX_WIDTH])
+{
+    __m256 t0 = _mm256_setzero_ps();
+    __m256 t1 = _mm256_set1_ps(t_max);
+    for (int axis=0; axis < 3; axis++) {
+        const float *near_plane = dir_is_neg[axis] ? node.maximum[axis] : node.minimum[axis];
+        const float *far_plane = dir_is_neg[axis] ? node.minimum[axis] : node.maximum[axis];
+        __m256 o = _mm256_set1_ps(origin[axis]);
+        __m256 inv = _mm256_set1_ps(inv_dir[axis]);
+        __m256 tn = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(near_plane), o), inv);
+        __m256 tf = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(far_plane), o), inv);
+        t0 = _mm256_max_ps(tn, t0);
+        t1 = _mm256_min_ps(tf, t1);
+    }
+    _mm256_storeu_ps(t_near, t0);
+    return _mm256_movemask_ps(_mm256_cmp_ps(t0, t1, _CMP_LE_OQ));
+}
+#endif
+
+//The node test runs with the same instruction set as the triangle packet kernels.
+int IntersectWideBVHNode(const WideBVHNode &node, const glm::vec3 &origin, const glm::vec3 &inv_dir,
+                         const int dir_is_neg[3], float t_max, float t_near[WIDE_BVH_MAX_WIDTH])
+{
+    switch (GetTrianglePacketKernel()) {
+#ifdef WIDE_BVH_AVX2
+    case PACKET_KERNEL_AVX2:
+        return IntersectNodeAVX2(node, origin, inv_dir, dir_is_neg, t_max, t_near);
+#endif
+#ifdef WIDE_BVH_SSE
+    case PACKET_KERNEL_SSE:
+        return IntersectNodeSSE(node, origin, inv_dir, dir_is_neg, t_max, t_near);
+#endif
+    default:
+        return IntersectNodeScalar(node, origin, inv_dir, dir_is_neg, t_max, t_near);
+    }
+}
+
+WideBVH::WideBVH() : width(WIDE_BVH_MAX_WIDTH)
+{}
+
+void WideBVH::Clear()
+{
+    nodes.clear();
+    primitives.clear();
+}
+
+void WideBVH::Collapse(const LinearBVH &binary, int width)
+{
+    Clear();
+    this->width = glm::clamp(width, 2, WIDE_BVH_MAX_WIDTH);
+    if (!binary.nodes.empty()) {
+        primitives = binary.primitives;
+        CollapseRecursive(binary, 0);
+    }
+}
+
+int WideBVH::CollapseRecursive(const LinearBVH &binary, int binary_index)
+{
+    int index = nodes.size();
+    nodes.push_back(WideBVHNode());
+
+    int children[WIDE_BVH_MAX_WIDTH];
+    int child_count = 0;
+    const LinearBVHNode &root = binary.nodes[binary_index];
+    if (root.primitive_count > 0) {
+        // Only happens when the whole binary tree is a single leaf.
+        children[child_count++] = binary_index;
+    } else {
+        children[child_count++] = binary_index + 1;
+        children[child_count++] = root.offset;
+    }
+
+    // Pull grandchildren up by opening the interior child with the largest surface area
+    // until the node is full or only leaves remain.
+    while (child_count < width) {
+        int largest = -1;
+        float largest_area = -1.0f;
+        for (int i=0; i < child_count; i++) {
+            const LinearBVHNode &child = binary.nodes[children[i]];
+            float area = BVHBoxArea(child.minimum, child.maximum);
+            if (child.primitive_count == 0 && area > largest_area) {
+                largest = i;
+                largest_area = area;
+            }
+        }
+        if (largest < 0) {
+            break;
+        }
+        int opened = children[largest];
+        children[largest] = opened + 1;
+        children[child_count++] = binary.nodes[opened].offset;
+    }
+
+    WideBVHNode node;
+    for (int lane=0; lane < child_count; lane++) {
+        const LinearBVHNode &child = binary.nodes[children[lane]];
+        for (int axis=0; axis < 3; axis++) {
+            node.minimum[axis][lane] = child.minimum[axis];
+            node.maximum[axis][lane] = child.maximum[axis];
+        }
+        if (child.primitive_count > 0) {
+            node.offset[lane] = child.offset;
+            node.primitive_count[lane] = child.primitive_count;
+        } else {
+            node.offset[lane] = CollapseRecursive(binary, children[lane]);
+        }
+    }
+    nodes[index] = node;
+    return index;
+}
+
+Intersection WideBVH::GetIntersection(const Ray &r) const
+{
+    ClosestHitTest closest_hit(primitives.data(), r);
+    float t_max = r.t_max;
+    Traverse(r, t_max, closest_hit);
+    return closest_hit.result;
+}
+
+bool WideBVH::Occluded(const Ray &r, float t_max) const
+{
+    AnyHitTest any_hit(primitives.data(), r);
+    Traverse(r, t_max, any_hit);
+    return any_hit.hit;
+}
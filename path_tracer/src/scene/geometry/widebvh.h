@@ -0,0 +1,107 @@
+#pragma once
+
+#include <la.h>
+#include <scene/geometry/bvhbuildoptions.h>
+#include <raytracing/ray.h>
+#include <vector>
+
+class LinearBVH;
+class Geometry;
+class Intersection;
+
+#define WIDE_BVH_MAX_WIDTH 8
+
+//A node with up to WIDE_BVH_MAX_WIDTH children whose bounds are stored in structure-of-arrays
+//form so that one SIMD slab test covers all of them. Unused lanes have inverted bounds.
+struct WideBVHNode {
+    WideBVHNode();
+
+    float minimum[3][WIDE_BVH_MAX_WIDTH];
+    float maximum[3][WIDE_BVH_MAX_WIDTH];
+    int offset[WIDE_BVH_MAX_WIDTH];             //Leaves: index of the first primitive. Interior children: node index.
+    int primitive_count[WIDE_BVH_MAX_WIDTH];    //0 for interior children and unused lanes.
+};
+
+//Slab tests the ray against every child of the node. Returns a bit mask of the lanes entered
+//before t_max and writes the entry distance of each lane to t_near.
+int IntersectWideBVHNode(const WideBVHNode &node, const glm::vec3 &origin, const glm::vec3 &inv_dir,
+                         const int dir_is_neg[3], float t_max, float t_near[WIDE_BVH_MAX_WIDTH]);
+
+//A 4- or 8-ary BVH made by collapsing a flattened binary BVH. Leaves index into the same
+//primitives as the binary tree they were made from.
+class WideBVH
+{
+public:
+    WideBVH();
+    //Replaces the contents of this BVH with a collapsed copy of the binary tree, keeping
+    //at most width children per node.
+    void Collapse(const LinearBVH &binary, int width);
+    void Clear();
+
+    Intersection GetIntersection(const Ray &r) const;
+    //Returns true if a non-transmissive primitive is hit before t_max, stopping at the first one found.
+    bool Occluded(const Ray &r, float t_max) const;
+
+    //Walks every child the ray enters before t_max, in order of entry distance. leaf_test(offset,
+    //count, t_max) is called for each leaf reached; it may shrink t_max to cull farther nodes, and
+    //returning true ends the traversal.
+    template <typename LeafTest>
+    void Traverse(const Ray &r, float &t_max, LeafTest &leaf_test) const;
+
+    int width;
+    std::vector<WideBVHNode> nodes;
+    std::vector<Geometry*> primitives;
+
+private:
+    int CollapseRecursive(const LinearBVH &binary, int binary_index);
+};
+
+template <typename LeafTest>
+void WideBVH::Traverse(const Ray &r, float &t_max, LeafTest &leaf_test) const
+{
+    if (nodes.empty()) {
+        return;
+    }
+    glm::vec3 inv_dir = 1.0f / r.direction;
+    int dir_is_neg[3] = {inv_dir.x < 0, inv_dir.y < 0, inv_dir.z < 0};
+
+    // Every level of the collapsed tree pushes at most width - 1 more entries than it pops.
+    struct StackEntry {
+        int offset;
+        int primitive_count;
+        float t_near;
+    };
+    StackEntry to_visit[BVH_MAX_DEPTH * (WIDE_BVH_MAX_WIDTH - 1) + 1];
+    int to_visit_count = 0;
+    to_visit[to_visit_count++] = {0, 0, 0.0f};
+    while (to_visit_count > 0) {
+        StackEntry entry = to_visit[--to_visit_count];
+        if (entry.t_near > t_max) {
+            continue;
+        }
+        if (entry.primitive_count > 0) {
+            if (leaf_test(entry.offset, entry.primitive_count, t_max)) {
+                return;
+            }
+            continue;
+        }
+
+        const WideBVHNode &node = nodes[entry.offset];
+        float t_near[WIDE_BVH_MAX_WIDTH];
+        int hits = IntersectWideBVHNode(node, r.origin, inv_dir, dir_is_neg, t_max, t_near);
+        // Sort the children that were hit from far to near so the nearest is popped first.
+        int first = to_visit_count;
+        for (int lane=0; hits != 0; lane++, hits >>= 1) {
+            if (!(hits & 1)) {
+                continue;
+            }
+            StackEntry child = {node.offset[lane], node.primitive_count[lane], t_near[lane]};
+            int i = to_visit_count++;
+            while (i > first && to_visit[i - 1].t_near < child.t_near) {
+                to_visit[i] = to_visit[i - 1];
+                i--;
+            }
+            to_visit[i] = child;
+        }
+    }
+}
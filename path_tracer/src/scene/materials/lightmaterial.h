@@ -5,7 +5,7 @@ class LightMaterial : public Material
 {
 public:
     //Already implemented. Just returns the emitted light color * intensity
-    virtual glm::vec3 EvaluateScatteredEnergy(const Intersection &isx, const glm::vec3 &woW, const glm::vec3 &wiW, BxDFType flags = BSDF_ALL) const;
+    virtual glm::vec3 EvaluateScatteredEnergy(const Intersection &isx, const glm::vec3 &woW, const glm::vec3 &wiW, Sampler &sampler, BxDFType flags = BSDF_ALL) const;
 
     //Given an intersection with some geometry, generate a point on the geometry to which this material is applied and
     //
@@ -19,9 +19,9 @@ Material::Material(const glm::vec3 &color):
     normal_map = NULL;
 }
 
-glm::vec3 Material::EvaluateScatteredEnergy(const Intersection &isx, const glm::vec3 &woW, const glm::vec3 &wiW, BxDFType flags) const
+glm::vec3 Material::EvaluateScatteredEnergy(const Intersection &isx, const glm::vec3 &woW, const glm::vec3 &wiW, Sampler &sampler, BxDFType flags) const
 {
-    int random_idx = rand() % bxdfs.size();
+    int random_idx = sampler.GetIndex(bxdfs.size());
     glm::vec3 woL = worldToObjectSpace(woW, isx);
     glm::vec3 wiL = worldToObjectSpace(wiW, isx);
     glm::vec3 energy =
@@ -31,18 +31,17 @@ glm::vec3 Material::EvaluateScatteredEnergy(const Intersection &isx, const glm::
     return energy;
 }
 
-glm::vec3 Material::SampleAndEvaluateScatteredEnergy(const Intersection &isx, const glm::vec3 &woW, glm::vec3 &wiW_ret, float &pdf_ret, BxDFType flags) const
+glm::vec3 Material::SampleAndEvaluateScatteredEnergy(const Intersection &isx, const glm::vec3 &woW, glm::vec3 &wiW_ret, float &pdf_ret, Sampler &sampler, BxDFType flags) const
 {
-    float x = float(rand()) / float(RAND_MAX);
-    float y = float(rand()) / float(RAND_MAX);
+    glm::vec2 bxdf_sample = sampler.Get2D();
 
-    BxDF *bxdf = bxdfs.at(rand() % bxdfs.size());
+    BxDF *bxdf = bxdfs.at(sampler.GetIndex(bxdfs.size()));
     glm::vec3 woL = worldToObjectSpace(woW, isx);
     glm::vec3 wiL_ret;
     glm::vec3 energy =
             base_color *
             isx.texture_color *
-            bxdf->SampleAndEvaluateScatteredEnergy(woL, wiL_ret, x, y, pdf_ret);
+            bxdf->SampleAndEvaluateScatteredEnergy(woL, wiL_ret, bxdf_sample.x, bxdf_sample.y, pdf_ret);
 
     wiW_ret = objectToWorldSpace(wiL_ret, isx);
     return energy;
@@ -4,6 +4,7 @@
 #include <scene/materials/bxdfs/bxdf.h>
 #include <raytracing/intersection.h>
 #include <raytracing/ray.h>
+#include <raytracing/samplers/sampler.h>
 #include <QImage>
 
 class Geometry;
@@ -19,10 +20,11 @@ public:
 
 //Functions
     //Given an intersection with some Geometry, evaluate the scattered energy at isx given a world-space wo and wi for all BxDFs we contain that match the input flags
-    virtual glm::vec3 EvaluateScatteredEnergy(const Intersection &isx, const glm::vec3 &woW, const glm::vec3 &wiW, BxDFType flags = BSDF_ALL) const;
+    //sampler is the calling render thread's sampler; it picks which BxDF is evaluated or sampled
+    virtual glm::vec3 EvaluateScatteredEnergy(const Intersection &isx, const glm::vec3 &woW, const glm::vec3 &wiW, Sampler &sampler, BxDFType flags = BSDF_ALL) const;
 
     //Given an intersection with some Geometry, generate a world-space wi then evaluate the scattered energy along the world-space wo.
-    virtual glm::vec3 SampleAndEvaluateScatteredEnergy(const Intersection &isx, const glm::vec3 &woW, glm::vec3 &wiW_ret, float &pdf_ret, BxDFType flags = BSDF_ALL) const;
+    virtual glm::vec3 SampleAndEvaluateScatteredEnergy(const Intersection &isx, const glm::vec3 &woW, glm::vec3 &wiW_ret, float &pdf_ret, Sampler &sampler, BxDFType flags = BSDF_ALL) const;
 
     //Given an intersection with some Geometry and a number of samples to take, generate a set of N random vec2s.
     //Then, pass this information to each BxDF that matches the input flags and return their combined EHSE results
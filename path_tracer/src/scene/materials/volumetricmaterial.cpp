@@ -2,7 +2,6 @@
 #include <QColor>
 #include <math.h>
 #include <mutex>
-#include <scene/camera.h>
 
 std::mutex mtx;           // mutex for critical section
 
@@ -151,10 +150,8 @@ float VolumetricMaterial::GetVoxelDensityAtPoint(const Intersection &intersectio
 }
 
 float VolumetricMaterial::SampleVolume(const Intersection &intersection, Ray &ray, glm::vec3 &out_point) {
-    Camera camera;
-
     Ray offset_ray(intersection.point + (ray.direction * 0.01f), ray.direction);
-    Intersection far_intersection = intersection.object_hit->GetIntersection(offset_ray, camera);
+    Intersection far_intersection = intersection.object_hit->GetIntersection(offset_ray);
     float ray_segment_length = far_intersection.t;
     float density = 0;
     glm::vec3 offset_point = intersection.point;
@@ -3,8 +3,8 @@
 WeightedMaterial::WeightedMaterial() : Material(){}
 WeightedMaterial::WeightedMaterial(const glm::vec3 &color) : Material(color){}
 
-BxDF *WeightedMaterial::chooseWeightedBxDF() const {
-    float rand_idx = float(rand()) / float(RAND_MAX);
+BxDF *WeightedMaterial::chooseWeightedBxDF(Sampler &sampler) const {
+    float rand_idx = sampler.Get1D();
     float weights = bxdf_weights.at(0);
     int i = 0;
     while (rand_idx > weights) {
@@ -13,20 +13,19 @@ BxDF *WeightedMaterial::chooseWeightedBxDF() const {
     return bxdfs.at(i);
 }
 
-glm::vec3 WeightedMaterial::EvaluateScatteredEnergy(const Intersection &isx, const glm::vec3 &woW, const glm::vec3 &wiW, BxDFType flags) const
+glm::vec3 WeightedMaterial::EvaluateScatteredEnergy(const Intersection &isx, const glm::vec3 &woW, const glm::vec3 &wiW, Sampler &sampler, BxDFType flags) const
 {
-    BxDF *random_bxdf = chooseWeightedBxDF();
+    BxDF *random_bxdf = chooseWeightedBxDF(sampler);
     return random_bxdf->EvaluateScatteredEnergy(woW, wiW)
             * base_color * isx.texture_color;
 }
 
-glm::vec3 WeightedMaterial::SampleAndEvaluateScatteredEnergy(const Intersection &isx, const glm::vec3 &woW, glm::vec3 &wiW_ret, float &pdf_ret, BxDFType flags) const
+glm::vec3 WeightedMaterial::SampleAndEvaluateScatteredEnergy(const Intersection &isx, const glm::vec3 &woW, glm::vec3 &wiW_ret, float &pdf_ret, Sampler &sampler, BxDFType flags) const
 {
-    float x = float(rand()) / float(RAND_MAX);
-    float y = float(rand()) / float(RAND_MAX);
+    glm::vec2 bxdf_sample = sampler.Get2D();
 
-    BxDF *bxdf = chooseWeightedBxDF();
+    BxDF *bxdf = chooseWeightedBxDF(sampler);
     return bxdf->SampleAndEvaluateScatteredEnergy(
-                woW, wiW_ret, x, y, pdf_ret)
+                woW, wiW_ret, bxdf_sample.x, bxdf_sample.y, pdf_ret)
             * base_color * isx.texture_color;
 }
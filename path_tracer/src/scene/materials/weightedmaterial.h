@@ -14,12 +14,12 @@ public:
     WeightedMaterial(const glm::vec3 &color);
 //Functions
     //Given an intersection with some Geometry, evaluate the scattered energy at isx given a world-space wo and wi for all BxDFs we contain that match the input flags
-    virtual glm::vec3 EvaluateScatteredEnergy(const Intersection &isx, const glm::vec3 &woW, const glm::vec3 &wiW, BxDFType flags = BSDF_ALL) const;
+    virtual glm::vec3 EvaluateScatteredEnergy(const Intersection &isx, const glm::vec3 &woW, const glm::vec3 &wiW, Sampler &sampler, BxDFType flags = BSDF_ALL) const;
 
     //Given an intersection with some Geometry, generate a world-space wi then evaluate the scattered energy along the world-space wo.
-    virtual glm::vec3 SampleAndEvaluateScatteredEnergy(const Intersection &isx, const glm::vec3 &woW, glm::vec3 &wiW_ret, float &pdf_ret, BxDFType flags = BSDF_ALL) const;
+    virtual glm::vec3 SampleAndEvaluateScatteredEnergy(const Intersection &isx, const glm::vec3 &woW, glm::vec3 &wiW_ret, float &pdf_ret, Sampler &sampler, BxDFType flags = BSDF_ALL) const;
 
-    BxDF *chooseWeightedBxDF() const;
+    BxDF *chooseWeightedBxDF(Sampler &sampler) const;
     //Members
     QList<float> bxdf_weights;
 };
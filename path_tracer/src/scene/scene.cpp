@@ -19,6 +19,18 @@ void Scene::SetCamera(const Camera &c)
     film.SetDimensions(c.width, c.height);
 }
 
+void Scene::BuildLightDistribution()
+{
+    std::vector<float> power;
+    for(Geometry *light : lights)
+    {
+        //Weigh the color by how bright it looks rather than summing its channels
+        float luminance = glm::dot(light->material->base_color, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+        power.push_back(light->material->intensity * light->area * luminance);
+    }
+    light_distribution.Build(power);
+}
+
 void Scene::CreateTestScene()
 {
     Material* diffuse1 = new Material(glm::vec3(1, 0, 0));
@@ -54,6 +66,7 @@ void Scene::Clear()
     }
     objects.clear();
     lights.clear();
+    light_distribution = AliasTable();
     for(Material *m : materials)
     {
         delete m;
@@ -66,4 +79,6 @@ void Scene::Clear()
     bxdfs.clear();
     camera = Camera();
     film = Film();
+    bvh_options = BVHBuildOptions();
+    render_options = RenderOptions();
 }
@@ -4,6 +4,9 @@
 #include <scene/camera.h>
 #include <raytracing/samplers/pixelsampler.h>
 #include <scene/geometry/geometry.h>
+#include <scene/geometry/bvhbuildoptions.h>
+#include <raytracing/renderoptions.h>
+#include <raytracing/samplers/aliastable.h>
 #include <scene/materials/bxdfs/bxdf.h>
 
 class Geometry;
@@ -21,8 +24,13 @@ public:
     Film film;
 
     unsigned int sqrt_samples;//Read by MyGL and RenderThread when making PixelSamplers
+    BVHBuildOptions bvh_options;//Read by MyGL when building the scene's BVH
+    RenderOptions render_options;//Read by MyGL when splitting a render into tiles
+    AliasTable light_distribution;//Picks lights in proportion to their power. Index i is lights[i].
 
     void SetCamera(const Camera &c);
+    //Rebuilds light_distribution from each light's intensity * area * color. Call after lights changes.
+    void BuildLightDistribution();
 
     void CreateTestScene();
     void Clear();
@@ -73,6 +73,9 @@ void XMLReader::LoadSceneFromFile(QFile &file, const QStringRef &local_path, Sce
                     if (QStringRef::compare(type, "photonMap") == 0)
                     {
                         integrator = LoadPhotonMapIntegrator(xml_reader);
+                    } else if (QStringRef::compare(type, "sppm") == 0 && dynamic_cast<SPPMIntegrator*>(&integrator) != NULL) {
+                        //Only an SPPMIntegrator can hold the SPPM settings
+                        *dynamic_cast<SPPMIntegrator*>(&integrator) = LoadSPPMIntegrator(xml_reader);
                     } else {
                         integrator = LoadIntegrator(xml_reader);
                     }
@@ -81,6 +84,14 @@ void XMLReader::LoadSceneFromFile(QFile &file, const QStringRef &local_path, Sce
                 {
                     scene.sqrt_samples = LoadPixelSamples(xml_reader);
                 }
+                else if(QString::compare(tag, QString("bvh")) == 0)
+                {
+                    scene.bvh_options = LoadBVHOptions(xml_reader);
+                }
+                else if(QString::compare(tag, QString("render")) == 0)
+                {
+                    scene.render_options = LoadRenderOptions(xml_reader);
+                }
             }
         }
         //Associate the materials in the XML file with the geometries that use those materials.
@@ -104,8 +115,10 @@ void XMLReader::LoadSceneFromFile(QFile &file, const QStringRef &local_path, Sce
 
         //Copy emissive geometry from the list of objects to the list of lights
         QList<Geometry*> to_lights;
+        int next_id = 0;
         for(Geometry *g : scene.objects)
         {
+            g->id = next_id++;
             g->create();
             if(g->material->is_light_source)
             {
@@ -117,6 +130,7 @@ void XMLReader::LoadSceneFromFile(QFile &file, const QStringRef &local_path, Sce
         {
             scene.lights.append(g);
         }
+        scene.BuildLightDistribution();
         file.close();
     }
 }
@@ -182,6 +196,14 @@ void XMLReader::LoadSceneFromFilePhotonMap(QFile &file, const QStringRef &local_
                 {
                     scene.sqrt_samples = LoadPixelSamples(xml_reader);
                 }
+                else if(QString::compare(tag, QString("bvh")) == 0)
+                {
+                    scene.bvh_options = LoadBVHOptions(xml_reader);
+                }
+                else if(QString::compare(tag, QString("render")) == 0)
+                {
+                    scene.render_options = LoadRenderOptions(xml_reader);
+                }
             }
         }
         //Associate the materials in the XML file with the geometries that use those materials.
@@ -205,8 +227,10 @@ void XMLReader::LoadSceneFromFilePhotonMap(QFile &file, const QStringRef &local_
 
         //Copy emissive geometry from the list of objects to the list of lights
         QList<Geometry*> to_lights;
+        int next_id = 0;
         for(Geometry *g : scene.objects)
         {
+            g->id = next_id++;
             g->create();
             if(g->material->is_light_source)
             {
@@ -218,6 +242,7 @@ void XMLReader::LoadSceneFromFilePhotonMap(QFile &file, const QStringRef &local_
         {
             scene.lights.append(g);
         }
+        scene.BuildLightDistribution();
         file.close();
     }
 }
@@ -590,12 +615,87 @@ PhotonMapIntegrator XMLReader::LoadPhotonMapIntegrator(QXmlStreamReader &xml_rea
             }
             xml_reader.readNext();
         }
+        else if (QString::compare(tag, "photonPaths") == 0)
+        {
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                result.SetPhotonPathsNum(xml_reader.text().toInt());
+            }
+            xml_reader.readNext();
+        }
+        else if (QString::compare(tag, "seed") == 0)
+        {
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                result.SetPhotonSeed(xml_reader.text().toUInt());
+            }
+            xml_reader.readNext();
+        }
+        else if (QString::compare(tag, "photonLookup") == 0)
+        {
+            //One of "kdTree" (default) or "hashGrid"
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                if(QStringRef::compare(xml_reader.text(), QString("hashGrid"), Qt::CaseInsensitive) == 0)
+                {
+                    result.SetPhotonLookup(PHOTON_LOOKUP_HASH_GRID);
+                }
+                else if(QStringRef::compare(xml_reader.text(), QString("kdTree"), Qt::CaseInsensitive) == 0)
+                {
+                    result.SetPhotonLookup(PHOTON_LOOKUP_KD_TREE);
+                }
+            }
+            xml_reader.readNext();
+        }
     }
 
 
     return result;
 }
 
+SPPMIntegrator XMLReader::LoadSPPMIntegrator(QXmlStreamReader &xml_reader)
+{
+    SPPMIntegrator result;
+
+    while(!xml_reader.isEndElement() || QStringRef::compare(xml_reader.name(), QString("integrator")) != 0)
+    {
+        xml_reader.readNext();
+
+        QString tag(xml_reader.name().toString());
+        if(QString::compare(tag, QString("maxDepth")) == 0)
+        {
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                result.SetDepth(xml_reader.text().toInt());
+            }
+            xml_reader.readNext();
+        }
+        else if (QString::compare(tag, "photonsPerIteration") == 0)
+        {
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                result.SetPhotonsPerIteration(xml_reader.text().toInt());
+            }
+            xml_reader.readNext();
+        }
+        else if (QString::compare(tag, "initialRadius") == 0)
+        {
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                result.SetInitialRadius(xml_reader.text().toFloat());
+            }
+            xml_reader.readNext();
+        }
+    }
+    return result;
+}
+
 Integrator XMLReader::LoadIntegrator(QXmlStreamReader &xml_reader)
 {
     Integrator result;
@@ -632,6 +732,254 @@ unsigned int XMLReader::LoadPixelSamples(QXmlStreamReader &xml_reader)
 }
 
 
+BVHBuildOptions XMLReader::LoadBVHOptions(QXmlStreamReader &xml_reader)
+{
+    BVHBuildOptions result;
+
+    //The split method is given by the type attribute: "sah" (default) or "median"
+    QXmlStreamAttributes attribs(xml_reader.attributes());
+    QStringRef type = attribs.value(QString(), QString("type"));
+    if(QStringRef::compare(type, QString("median"), Qt::CaseInsensitive) == 0)
+    {
+        result.split_method = BVH_SPLIT_MEDIAN;
+    }
+
+    while(!xml_reader.isEndElement() || QStringRef::compare(xml_reader.name(), QString("bvh")) != 0)
+    {
+        xml_reader.readNext();
+
+        QString tag(xml_reader.name().toString());
+        if(QString::compare(tag, QString("maxLeafSize")) == 0)
+        {
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                result.max_leaf_size = glm::clamp(xml_reader.text().toInt(), 1, BVH_MAX_LEAF_SIZE);
+            }
+            xml_reader.readNext();
+        }
+        else if(QString::compare(tag, QString("binCount")) == 0)
+        {
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                result.bin_count = xml_reader.text().toInt();
+            }
+            xml_reader.readNext();
+        }
+        else if(QString::compare(tag, QString("traversalCost")) == 0)
+        {
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                result.traversal_cost = xml_reader.text().toFloat();
+            }
+            xml_reader.readNext();
+        }
+        else if(QString::compare(tag, QString("intersectionCost")) == 0)
+        {
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                result.intersection_cost = xml_reader.text().toFloat();
+            }
+            xml_reader.readNext();
+        }
+        else if(QString::compare(tag, QString("branchingFactor")) == 0)
+        {
+            //2, 4 or 8. Anything else keeps the binary tree.
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                int branching_factor = xml_reader.text().toInt();
+                if(branching_factor == 2 || branching_factor == 4 || branching_factor == 8)
+                {
+                    result.branching_factor = branching_factor;
+                }
+                else
+                {
+                    std::cout << "Could not parse the branching factor " << xml_reader.text().toString().toStdString()
+                              << ", it must be 2, 4 or 8!" << std::endl;
+                }
+            }
+            xml_reader.readNext();
+        }
+        else if(QString::compare(tag, QString("threads")) == 0)
+        {
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                result.thread_count = xml_reader.text().toInt();
+            }
+            xml_reader.readNext();
+        }
+        else if(QString::compare(tag, QString("benchmark")) == 0)
+        {
+            //"true" or "1"
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                result.benchmark = QStringRef::compare(xml_reader.text(), QString("true"), Qt::CaseInsensitive) == 0
+                        || xml_reader.text().toInt() != 0;
+            }
+            xml_reader.readNext();
+        }
+    }
+    return result;
+}
+
+RenderOptions XMLReader::LoadRenderOptions(QXmlStreamReader &xml_reader)
+{
+    RenderOptions result;
+
+    while(!xml_reader.isEndElement() || QStringRef::compare(xml_reader.name(), QString("render")) != 0)
+    {
+        xml_reader.readNext();
+
+        QString tag(xml_reader.name().toString());
+        if(QString::compare(tag, QString("tileSize")) == 0)
+        {
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                result.tile_size = xml_reader.text().toInt();
+            }
+            xml_reader.readNext();
+        }
+        else if(QString::compare(tag, QString("tileOrder")) == 0)
+        {
+            //One of "scanline", "hilbert" (default) or "centerOut"
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                QStringRef order = xml_reader.text();
+                if(QStringRef::compare(order, QString("scanline"), Qt::CaseInsensitive) == 0)
+                {
+                    result.tile_order = TILE_ORDER_SCANLINE;
+                }
+                else if(QStringRef::compare(order, QString("centerOut"), Qt::CaseInsensitive) == 0)
+                {
+                    result.tile_order = TILE_ORDER_CENTER_OUT;
+                }
+            }
+            xml_reader.readNext();
+        }
+        else if(QString::compare(tag, QString("threads")) == 0)
+        {
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                result.thread_count = xml_reader.text().toInt();
+            }
+            xml_reader.readNext();
+        }
+        else if(QString::compare(tag, QString("sampler")) == 0)
+        {
+            //One of "sobol" (default), "halton" or "independent"
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                QStringRef type = xml_reader.text();
+                if(QStringRef::compare(type, QString("halton"), Qt::CaseInsensitive) == 0)
+                {
+                    result.sampler_type = SAMPLER_HALTON;
+                }
+                else if(QStringRef::compare(type, QString("independent"), Qt::CaseInsensitive) == 0)
+                {
+                    result.sampler_type = SAMPLER_INDEPENDENT;
+                }
+            }
+            xml_reader.readNext();
+        }
+        else if(QString::compare(tag, QString("filter")) == 0)
+        {
+            //One of "box" (default), "tent", "gaussian" or "mitchell"
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                QStringRef type = xml_reader.text();
+                if(QStringRef::compare(type, QString("tent"), Qt::CaseInsensitive) == 0)
+                {
+                    result.filter_type = FILTER_TENT;
+                }
+                else if(QStringRef::compare(type, QString("gaussian"), Qt::CaseInsensitive) == 0)
+                {
+                    result.filter_type = FILTER_GAUSSIAN;
+                }
+                else if(QStringRef::compare(type, QString("mitchell"), Qt::CaseInsensitive) == 0)
+                {
+                    result.filter_type = FILTER_MITCHELL;
+                }
+            }
+            xml_reader.readNext();
+        }
+        else if(QString::compare(tag, QString("filterRadius")) == 0)
+        {
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                result.filter_radius = xml_reader.text().toFloat();
+            }
+            xml_reader.readNext();
+        }
+        else if(QString::compare(tag, QString("samplesPerPass")) == 0)
+        {
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                result.samples_per_pass = xml_reader.text().toInt();
+            }
+            xml_reader.readNext();
+        }
+        else if(QString::compare(tag, QString("maxSamples")) == 0)
+        {
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                result.max_samples = xml_reader.text().toInt();
+            }
+            xml_reader.readNext();
+        }
+        else if(QString::compare(tag, QString("timeLimit")) == 0)
+        {
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                result.time_limit = xml_reader.text().toFloat();
+            }
+            xml_reader.readNext();
+        }
+        else if(QString::compare(tag, QString("noiseThreshold")) == 0)
+        {
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                result.noise_threshold = xml_reader.text().toFloat();
+            }
+            xml_reader.readNext();
+        }
+        else if(QString::compare(tag, QString("adaptiveThreshold")) == 0)
+        {
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                result.adaptive_threshold = xml_reader.text().toFloat();
+            }
+            xml_reader.readNext();
+        }
+        else if(QString::compare(tag, QString("adaptiveMinSamples")) == 0)
+        {
+            xml_reader.readNext();
+            if(xml_reader.isCharacters())
+            {
+                result.adaptive_min_samples = xml_reader.text().toInt();
+            }
+            xml_reader.readNext();
+        }
+    }
+    return result;
+}
+
 QImage* XMLReader::LoadTextureFile(QXmlStreamReader &xml_reader, const QStringRef &local_path)
 {
     xml_reader.readNext();
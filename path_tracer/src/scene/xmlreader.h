@@ -8,6 +8,7 @@
 #include <scene/geometry/geometry.h>
 #include <raytracing/integrator.h>
 #include <raytracing/photonmapintegrator.h>
+#include <raytracing/sppmintegrator.h>
 
 class XMLReader
 {
@@ -19,8 +20,11 @@ public:
     Camera LoadCamera(QXmlStreamReader &xml_reader);
     Transform LoadTransform(QXmlStreamReader &xml_reader);
     PhotonMapIntegrator LoadPhotonMapIntegrator(QXmlStreamReader &xml_reader);
+    SPPMIntegrator LoadSPPMIntegrator(QXmlStreamReader &xml_reader);
     Integrator LoadIntegrator(QXmlStreamReader &xml_reader);
     unsigned int LoadPixelSamples(QXmlStreamReader &xml_reader);
+    BVHBuildOptions LoadBVHOptions(QXmlStreamReader &xml_reader);
+    RenderOptions LoadRenderOptions(QXmlStreamReader &xml_reader);
     QImage* LoadTextureFile(QXmlStreamReader &xml_reader, const QStringRef &local_path);
     BxDF* LoadBxDF(QXmlStreamReader &xml_reader);
     glm::vec3 ToVec3(const QStringRef &s);
@@ -11,7 +11,8 @@ Integrator::Integrator():
 
 // Light feeler test. Check that current light is visible from point.
 // If so, return the color produces by the light.
-// TODO: Special case for lights obscured by transparent objects with stuff behind.
+// Lights behind an opaque object are found with an early-exit occlusion query; the closest hit is
+// only needed when the light is seen through a transparent object.
 glm::vec3 Integrator::ShadowTest(glm::vec3 &point, Geometry *light, int depth) {
     if (depth > max_depth) {
         return glm::vec3(1, 1, 1);
@@ -20,15 +21,22 @@ glm::vec3 Integrator::ShadowTest(glm::vec3 &point, Geometry *light, int depth) {
     glm::vec3 light_center = glm::vec3(light->transform.T()
                                        * glm::vec4(0.0f,0.0f,0.0f,1.0f));
     Ray ray_to_light = Ray(point, light_center - point);
-    Intersection intersection = intersection_engine->GetIntersection(ray_to_light);
-    if (intersection.object_hit == light) {
-        // If hit object is the light or a transparent object, set light color to base color.
-        light_color = intersection.object_hit->material->base_color;
-    } else if (intersection.object_hit->material->refract_idx_in > 0) {
-        // If light is obscured, by transparent object, return
-        // light color * material color.
+    Intersection light_intersection = light->GetIntersection(ray_to_light);
+    if (!light_intersection.object_hit) {
+        return light_color;
+    }
+    bool transparent_hit;
+    if (intersection_engine->Occluded(ray_to_light, light_intersection.t - OFFSET, transparent_hit)) {
+        return light_color;
+    }
+    if (!transparent_hit) {
+        light_color = light->material->base_color;
+    } else {
+        // If light is obscured by a transparent object, return
+        // the color of the closest one.
         //glm::vec3 offset_point = intersection.point + (intersection.normal * OFFSET);
         //light_color = intersection.color * ShadowTest(offset_point, light, depth+1);
+        Intersection intersection = intersection_engine->GetIntersection(ray_to_light);
         light_color = intersection.color;
     }
     return light_color;
@@ -18,5 +18,11 @@ IntersectionEngine::IntersectionEngine()
 // If ignoreTransparent is set to true, ignores transparent objects.
 Intersection IntersectionEngine::GetIntersection(Ray r)
 {
-    return bvh->GetIntersection(r, scene->camera);
+    return bvh->GetIntersection(r);
+}
+
+bool IntersectionEngine::Occluded(Ray r, float t_max, bool &transparent_hit)
+{
+    transparent_hit = false;
+    return bvh->Occluded(r, t_max, transparent_hit);
 }
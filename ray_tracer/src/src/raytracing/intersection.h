@@ -34,4 +34,8 @@ public:
     // use_transparent: consider intersections with transparent objects.
     // clip: ignore intersections falling outside of the frustrum.
     Intersection GetIntersection(Ray r);
+
+    // Returns true if an opaque object blocks the ray before t_max, stopping at the first one found.
+    // transparent_hit is set when the ray passes through a transparent object on the way.
+    bool Occluded(Ray r, float t_max, bool &transparent_hit);
 };
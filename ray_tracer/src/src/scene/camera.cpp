@@ -162,7 +162,19 @@ Ray Camera::RaycastNDC(float ndc_x, float ndc_y)
 {
     glm::vec3 worldView = ref + ndc_x * H + ndc_y * V;
     glm::vec3 direction = glm::normalize(worldView - eye);
-    return Ray(eye, direction);
+    Ray result(eye, direction);
+    SetClipRange(result);
+    return result;
+}
+
+//Turns the near and far clip planes into the range of distances along the ray that may be hit,
+//so that intersection tests never need the view matrix.
+void Camera::SetClipRange(Ray &r) const
+{
+    float depth_per_t = glm::dot(r.direction, look);
+    float origin_depth = glm::dot(r.origin - eye, look);
+    r.t_min = (near_clip - origin_depth) / depth_per_t;
+    r.t_max = (far_clip - origin_depth) / depth_per_t;
 }
 
 void Camera::create()
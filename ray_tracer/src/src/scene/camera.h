@@ -43,6 +43,7 @@ public:
     Ray Raycast(const glm::vec2 &pt);         //Creates a ray in 3D space given a 2D point on the screen, in screen coordinates.
     Ray Raycast(float x, float y);            //Same as above, but takes two floats rather than a vec2.
     Ray RaycastNDC(float ndc_x, float ndc_y); //Creates a ray in 3D space given a 2D point in normalized device coordinates.
+    void SetClipRange(Ray &r) const;          //Limits the ray to the hits that lie between the clip planes.
 
     void RotateAboutUp(float deg);
     void RotateAboutRight(float deg);
@@ -224,31 +224,26 @@ void bvhNode::FlattenTree(bvhNode *root, std::vector<bvhNode*> &nodes) {
     FlattenTree(root->right, nodes);
 }
 
-Intersection bvhNode::GetIntersection(Ray r, Camera &camera)
+Intersection bvhNode::GetIntersection(Ray r)
 {
     Intersection intersection;
     if (!bounding_box.GetIntersection(r)) {
         return intersection;
     }
     if (bounding_box.object) {
-        Intersection current = bounding_box.object->GetIntersection(r, camera);
-        if (current.object_hit) {
-            // Transform point into camera space to check for clipping.
-            glm::vec3 world_point = glm::vec3(camera.ViewMatrix()
-                                              * glm::vec4(current.point, 1.0f));
-            if (world_point.z > camera.near_clip
-                && world_point.z < camera.far_clip) {
-                intersection = current;
-            }
+        Intersection current = bounding_box.object->GetIntersection(r);
+        // Hits outside the ray's range, e.g. beyond the camera's clip planes, are dropped.
+        if (current.object_hit && current.t >= r.t_min && current.t < r.t_max) {
+            intersection = current;
         }
         return intersection;
     }
 
     Intersection child0, child1;
     if (left)
-        child0 = left->GetIntersection(r, camera);
+        child0 = left->GetIntersection(r);
     if (right)
-        child1 = right->GetIntersection(r, camera);
+        child1 = right->GetIntersection(r);
 
     if (left && child0.object_hit) {
         intersection = child0;
@@ -262,6 +257,28 @@ Intersection bvhNode::GetIntersection(Ray r, Camera &camera)
     return intersection;
 }
 
+// Any-hit query for shadow rays. Returns true as soon as an opaque object is hit closer than t_max.
+// Transparent objects don't block the ray; transparent_hit records whether one was passed.
+bool bvhNode::Occluded(Ray r, float t_max, bool &transparent_hit)
+{
+    if (!bounding_box.GetIntersection(r)) {
+        return false;
+    }
+    if (bounding_box.object) {
+        Intersection current = bounding_box.object->GetIntersection(r);
+        if (!current.object_hit || current.t >= t_max) {
+            return false;
+        }
+        if (current.object_hit->material->refract_idx_in > 0) {
+            transparent_hit = true;
+            return false;
+        }
+        return true;
+    }
+    return (left && left->Occluded(r, t_max, transparent_hit))
+            || (right && right->Occluded(r, t_max, transparent_hit));
+}
+
 void bvhNode::DeleteTree(bvhNode * root) {
     if (root == NULL) {
         return;
@@ -45,7 +45,8 @@ public:
     static bvhNode *InitTree(QList<Geometry*> objects);
     static void DeleteTree(bvhNode * root);
     static void FlattenTree(bvhNode *root, std::vector<bvhNode*> &nodes);
-    Intersection GetIntersection(Ray r, Camera &camera);
+    Intersection GetIntersection(Ray r);
+    bool Occluded(Ray r, float t_max, bool &transparent_hit);
 
     BoundingBox bounding_box;
     bvhNode *left;
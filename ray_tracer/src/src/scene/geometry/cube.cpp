@@ -10,7 +10,7 @@ bool nearlyEquals(float x, float y) {
     return std::abs(x-y) < EPSILON;
 }
 
-Intersection Cube::GetIntersection(Ray r, Camera &camera)
+Intersection Cube::GetIntersection(Ray r)
 {
     Intersection intersection;
     Ray r_local = r.GetTransformedCopy(transform.invT());
@@ -25,7 +25,7 @@ public:
     }
 
     virtual ~Geometry(){}
-    virtual Intersection GetIntersection(Ray r, Camera &camera) = 0;
+    virtual Intersection GetIntersection(Ray r) = 0;
     virtual void SetMaterial(Material* m){material = m;}
     virtual glm::vec2 GetUVCoordinates(const glm::vec3 &point) = 0;
     //virtual glm::vec3 SampleAreaLight(Ray r) = 0;
@@ -62,7 +62,7 @@ glm::vec4 Triangle::GetNormal(const glm::vec4 &position)
 }
 
 //HAVE THEM IMPLEMENT THIS
-Intersection Triangle::GetIntersection(Ray r, Camera &camera)
+Intersection Triangle::GetIntersection(Ray r)
 {
     // Get ray in local space.
     Ray r_local = r.GetTransformedCopy(transform.invT());
@@ -160,11 +160,11 @@ bvhNode *Triangle::SetBoundingBox() {
     return node;
 }
 
-Intersection Mesh::GetIntersection(Ray r, Camera &camera)
+Intersection Mesh::GetIntersection(Ray r)
 {
     Intersection intersection;
 
-    intersection = bvh->GetIntersection(r, camera);
+    intersection = bvh->GetIntersection(r);
     intersection.point = glm::vec3(transform.T() * glm::vec4(intersection.point, 1.0f));
     intersection.normal = glm::normalize(glm::vec3(transform.invTransT()
                                                    * glm::vec4(intersection.normal, 0.0f)));
@@ -19,7 +19,7 @@ glm::vec2 Sphere::GetUVCoordinates(const glm::vec3 &point) {
     return glm::vec2(U, V);
 }
 
-Intersection Sphere::GetIntersection(Ray r, Camera &camera)
+Intersection Sphere::GetIntersection(Ray r)
 {
     // Get ray in local space.
     Ray r_local = r.GetTransformedCopy(transform.invT());
@@ -7,7 +7,7 @@
 class Sphere : public Geometry
 {
 public:
-    Intersection GetIntersection(Ray r, Camera &camera);
+    Intersection GetIntersection(Ray r);
     glm::vec2 GetUVCoordinates(const glm::vec3 &point);
     //glm::vec3 SampleAreaLight(Ray r);
     glm::vec3 NormalMapping(const glm::vec3 &point, const glm::vec3 &normal);
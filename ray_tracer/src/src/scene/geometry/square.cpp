@@ -1,6 +1,6 @@
 #include <scene/geometry/square.h>
 
-Intersection SquarePlane::GetIntersection(Ray r, Camera &camera)
+Intersection SquarePlane::GetIntersection(Ray r)
 {
     // Get ray in local space.
     Ray r_local = r.GetTransformedCopy(transform.invT());
@@ -5,7 +5,7 @@
 //These attributes can be altered by applying a transformation matrix to the square.
 class SquarePlane : public Geometry
 {
-    Intersection GetIntersection(Ray r, Camera &camera);
+    Intersection GetIntersection(Ray r);
     glm::vec2 GetUVCoordinates(const glm::vec3 &point);
     glm::vec3 NormalMapping(const glm::vec3 &point, const glm::vec3 &normal);
     bvhNode *SetBoundingBox();